@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only view of a contiguous array owned by someone else
+template<typename T>
+class ArrayView {
+ public:
+    ArrayView() = default;
+    ArrayView(const T *data, size_t size) : m_Data(data), m_Size(size) {}
+
+    const T *data() const { return m_Data; }
+    size_t size() const { return m_Size; }
+    bool empty() const { return m_Size == 0; }
+    const T &operator[](size_t index) const { return m_Data[index]; }
+
+    const T *begin() const { return m_Data; }
+    const T *end() const { return m_Data + m_Size; }
+
+ private:
+    const T *m_Data = nullptr;
+    size_t m_Size = 0;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <unordered_map>
+#include "job_system.hpp"
+#include "path_resolver.hpp"
+
+struct aiScene;
+struct TextureAsset;
+class Model;
+class Font;
+class ShaderProgram;
+
+// Asset loaded in the background, holds nullptr if loading failed
+template<typename T>
+using AssetFuture = std::shared_future<std::shared_ptr<T>>;
+
+// Loaded assets keyed by path resolved with GetResourcePath, so every file
+// is read and parsed once. Assets are handed out as shared pointers: the
+// cache holds one reference and every user another one. An asset is freed
+// once it is unloaded from the cache and no user holds it any more.
+// Loaders return nullptr when the file can't be loaded.
+//
+// Load functions must be called on the thread owning the GL context.
+// Async ones may be called from anywhere: reading, parsing and decoding
+// run on loader threads, GL upload is queued and run by ProcessUploads.
+class AssetManager {
+ public:
+    // Imported model file, shared by models and skeletal animations of the file
+    static std::shared_ptr<const aiScene> LoadScene(const std::string &path);
+    // Model with every mesh of the file, Model::loadFromFile returns copies of it.
+    // Baked model of the file is mapped instead of importing it if it is up to date
+    static std::shared_ptr<const Model> LoadModel(const std::string &path);
+    // Same as LoadModel, but the model is read on a loader thread.
+    // Textures of its materials are decoded there as well
+    static AssetFuture<const Model> LoadModelAsync(const std::string &path);
+    static AssetFuture<const TextureAsset> LoadTextureAsync(const std::string &path);
+    // Runs queued uploads of async loads for at least `budget` seconds or until
+    // the queue is empty. Engine calls it once per frame, see ASSET_UPLOAD_BUDGET.
+    // Returns number of uploads left
+    static int ProcessUploads(double budget);
+
+    // Imports the model file and writes its baked model next to it
+    static bool BakeModel(const std::string &path);
+    // Texture of a material, from resources/textures
+    static std::shared_ptr<const TextureAsset> LoadTexture(const std::string &path);
+    // Texture of an on-screen image, from resources/images
+    static std::shared_ptr<const TextureAsset> LoadImage(const std::string &path);
+    static std::shared_ptr<ShaderProgram> LoadShaderProgram(const std::string &vertexPath,
+                                                            const std::string &fragmentPath);
+    static std::shared_ptr<Font> LoadFont(const std::string &path, unsigned int size);
+
+    // Drops cached assets loaded from the file. Users keep their references
+    static void Unload(Resource, const std::string &path);
+    // Drops cached assets that nobody else references
+    static void UnloadUnused();
+    static void UnloadAll();
+
+ private:
+    template<typename Key, typename T>
+    using Cache = std::map<Key, std::shared_ptr<T>>;
+
+    static Cache<std::string, const aiScene> s_Scenes;
+    static Cache<std::string, const Model> s_Models;
+    static Cache<std::string, const TextureAsset> s_Textures;
+    static Cache<std::string, const TextureAsset> s_Images;
+    static Cache<std::pair<std::string, std::string>, ShaderProgram> s_ShaderPrograms;
+    static Cache<std::pair<std::string, unsigned int>, Font> s_Fonts;
+    // Guards caches and pending loads, never held while loading
+    static std::mutex s_Mutex;
+
+    // Async loads not uploaded yet, keyed as their caches
+    static std::map<std::string, AssetFuture<const Model>> s_PendingModels;
+    static std::map<std::string, AssetFuture<const TextureAsset>> s_PendingTextures;
+    static std::mutex s_UploadMutex;
+    static std::deque<std::function<void()>> s_Uploads;
+    static std::unique_ptr<JobSystem> s_Loader;
+
+    template<typename Key, typename T, typename F>
+    static std::shared_ptr<T> FindOrLoad(Cache<Key, T> *cache, const Key &key, F load);
+    static void RunInBackground(std::function<void()> task);
+    static void QueueUpload(std::function<void()> upload);
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// Platform backends available to the process.
+// Headless Engine turns graphics and audio off, resources created afterwards
+// keep CPU side data only: meshes get no GL buffers, textures, images, fonts
+// and shaders are not loaded, sounds are not opened. Rendering functions
+// must not be called without graphics.
+class Backend {
+ private:
+    static bool s_Headless;
+
+ public:
+    static bool HasGraphics();
+    static bool HasAudio();
+    static void SetHeadless(bool);
+};
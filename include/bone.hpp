@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -30,16 +32,11 @@ class Bone {
     std::vector<KeyRotation> m_Rotations;
     std::vector<KeyScale> m_Scales;
     int m_NumPositions;
-    int m_LastPositionIndex;
     int m_NumRotations;
-    int m_LastRotationIndex;
     int m_NumScalings;
-    int m_LastScalingIndex;
 
-    glm::mat4 m_LocalTransform;
     std::string m_Name;
     int m_ID = -1;
-    float m_LastAnimationTime;
 
  public:
     Bone() = default;
@@ -48,9 +45,7 @@ class Bone {
         m_NumPositions = channel->mNumPositionKeys;
         m_Name = name;
         m_ID = ID;
-        m_LocalTransform = glm::mat4(1.0f);
 
-        m_LastPositionIndex = 0;
         for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex) {
             aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
             float timeStamp = static_cast<float>(channel->mPositionKeys[positionIndex].mTime);
@@ -60,7 +55,6 @@ class Bone {
             m_Positions.push_back(data);
         }
 
-        m_LastRotationIndex = 0;
         m_NumRotations = channel->mNumRotationKeys;
         for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex) {
             aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
@@ -71,7 +65,6 @@ class Bone {
             m_Rotations.push_back(data);
         }
 
-        m_LastScalingIndex = 0;
         m_NumScalings = channel->mNumScalingKeys;
         for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex) {
             aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
@@ -84,73 +77,67 @@ class Bone {
     }
 
     /*interpolates  b/w positions,rotations & scaling keys based on the curren time of 
-    the animation and prepares the local transformation matrix by combining all keys 
-    tranformations*/
-    void Update(float animationTime) {
-        if (animationTime < m_LastAnimationTime) {
-            m_LastPositionIndex = 0;
-            m_LastRotationIndex = 0;
-            m_LastScalingIndex = 0;
-        }
-
+    the animation and returns the local transformation matrix combining all keys 
+    tranformations. Bone is not modified, so animation data can be shared by
+    managers updated from different threads*/
+    glm::mat4 GetLocalTransform(float animationTime) const {
         glm::mat4 translation = InterpolatePosition(animationTime);
         glm::mat4 rotation = InterpolateRotation(animationTime);
         glm::mat4 scale = InterpolateScaling(animationTime);
-        m_LastAnimationTime = animationTime;
-        m_LocalTransform = translation * rotation * scale;
+        return translation * rotation * scale;
     }
 
-    glm::mat4 GetLocalTransform() { return m_LocalTransform; }
     std::string GetBoneName() const { return m_Name; }
-    int GetBoneID() { return m_ID; }
+    int GetBoneID() const { return m_ID; }
 
 
     /* Gets the current index on mKeyPositions to interpolate to based on 
     the current animation time*/
-    int GetPositionIndex(float animationTime) {
-        for (; m_LastPositionIndex < m_NumPositions - 1; ++m_LastPositionIndex) {
-            if (animationTime < m_Positions[m_LastPositionIndex + 1].timeStamp)
-                return m_LastPositionIndex;
-        }
-        Logger::Error("SKELETAL ANIM: Can't find current timeStamp");
-        assert(0);
-        return -1;
+    int GetPositionIndex(float animationTime) const {
+        return FindKeyIndex(m_Positions, animationTime);
     }
 
     /* Gets the current index on mKeyRotations to interpolate to based on the 
     current animation time*/
-    int GetRotationIndex(float animationTime) {
-        for (; m_LastRotationIndex < m_NumRotations - 1; ++m_LastRotationIndex) {
-            if (animationTime < m_Rotations[m_LastRotationIndex + 1].timeStamp)
-                return m_LastRotationIndex;
-        }
-        Logger::Error("SKELETAL ANIM: Can't find current timeStamp");
-        assert(0);
-        return -1;
+    int GetRotationIndex(float animationTime) const {
+        return FindKeyIndex(m_Rotations, animationTime);
     }
 
 
     /* Gets the current index on mKeyScalings to interpolate to based on the 
     current animation time */
-    int GetScaleIndex(float animationTime) {
-         for (; m_LastScalingIndex < m_NumScalings - 1; ++m_LastScalingIndex) {
-            if (animationTime < m_Scales[m_LastScalingIndex + 1].timeStamp)
-                return m_LastScalingIndex;
-        }
-        Logger::Error("SKELETAL ANIM: Can't find current timeStamp");
-        assert(0);
-        return -1;
+    int GetScaleIndex(float animationTime) const {
+        return FindKeyIndex(m_Scales, animationTime);
     }
 
  private:
+    /* Binary search of the last key starting before animationTime, keys are
+    sorted by timestamp*/
+    template<typename Key>
+    static int FindKeyIndex(const std::vector<Key> &keys, float animationTime) {
+        if (keys.size() < 2) {
+            Logger::Error("SKELETAL ANIM: Can't find current timeStamp");
+            assert(0);
+            return -1;
+        }
+        auto next = std::upper_bound(keys.begin() + 1, keys.end(), animationTime,
+            [](float time, const Key &key) { return time < key.timeStamp; });
+        if (next == keys.end()) {
+            Logger::Error("SKELETAL ANIM: Can't find current timeStamp");
+            assert(0);
+            return -1;
+        }
+        return static_cast<int>(next - keys.begin()) - 1;
+    }
+
     /* Gets normalized value for Lerp & Slerp*/
-    float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) {
+    float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const {
         return (animationTime - lastTimeStamp) / (nextTimeStamp - lastTimeStamp);
     }
 
     /*figures out which position keys to interpolate b/w and performs the interpolation 
     and returns the translation matrix*/
-    glm::mat4 InterpolatePosition(float animationTime) {
+    glm::mat4 InterpolatePosition(float animationTime) const {
         if (1 == m_NumPositions)
             return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
 
@@ -165,7 +152,7 @@ class Bone {
 
     /*figures out which rotations keys to interpolate b/w and performs the interpolation 
     and returns the rotation matrix*/
-    glm::mat4 InterpolateRotation(float animationTime) {
+    glm::mat4 InterpolateRotation(float animationTime) const {
         if (1 == m_NumRotations) {
             auto rotation = glm::normalize(m_Rotations[0].orientation);
             return glm::toMat4(rotation);
@@ -183,7 +170,7 @@ class Bone {
 
     /*figures out which scaling keys to interpolate b/w and performs the interpolation 
     and returns the scale matrix*/
-    glm::mat4 InterpolateScaling(float animationTime) {
+    glm::mat4 InterpolateScaling(float animationTime) const {
         if (1 == m_NumScalings)
             return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
 
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "geometry_primitives.hpp"
+#include "engine_config.hpp"
+#include "handle.hpp"
+
+struct BroadphasePair {
+    ObjectHandle a, b;
+};
+
+bool Overlap(const AABB &, const AABB &);
+
+// Called with a proxy hit by a ray and the distance at which the ray enters
+// its bounds. Returns distance beyond which proxies are not needed anymore.
+// Refers to the callable without copying it, so it must outlive the visitor
+// and casting a ray allocates nothing
+class RayVisitor {
+ public:
+    template <typename F>
+    RayVisitor(const F &visit)  // NOLINT(runtime/explicit)
+        : m_Data(&visit), m_Invoke([](const void *data, ObjectHandle handle, float distance) {
+              return (*static_cast<const F *>(data))(handle, distance);
+          }) {}
+
+    float operator()(ObjectHandle handle, float distance) const {
+        return m_Invoke(m_Data, handle, distance);
+    }
+
+ private:
+    const void *m_Data;
+    float (*m_Invoke)(const void *, ObjectHandle, float);
+};
+
+// Broadphase keeps world-space bounds of every collider between frames
+// and reports pairs whose bounds overlap. Only those pairs are handed to
+// the narrowphase (CollidePrimitive and friends).
+class Broadphase {
+ public:
+    virtual ~Broadphase() = default;
+
+    // Insert proxy for handle or move existing one
+    virtual void Update(ObjectHandle, AABB bounds) = 0;
+    virtual void Remove(ObjectHandle) = 0;
+
+    // Appends every overlapping pair to `out`. Each pair is reported once.
+    virtual void FindPairs(std::vector<BroadphasePair> *out) = 0;
+
+    // Appends every handle whose bounds overlap `bounds` to `out`.
+    // Each handle is reported once.
+    virtual void Query(AABB bounds, std::vector<ObjectHandle> *out) = 0;
+
+    // Brings internal structures up to date with Update and Remove calls.
+    // Raycast does not do it, so rays may be cast from several threads at once
+    virtual void Refresh() = 0;
+
+    // Calls visit for proxies whose bounds the ray enters closer than
+    // `maxDistance`, which shrinks to whatever visit returns. Proxies come
+    // roughly nearest first and may be visited more than once.
+    // Refresh must be called after the last Update or Remove
+    virtual void Raycast(const Ray &, float maxDistance, RayVisitor visit) const = 0;
+};
+
+// Sorts proxies along x axis and sweeps.
+// Order is kept between frames, so insertion sort runs in almost linear time
+// when objects move coherently.
+class SweepAndPrune : public Broadphase {
+ public:
+    void Update(ObjectHandle, AABB bounds) override;
+    void Remove(ObjectHandle) override;
+    void FindPairs(std::vector<BroadphasePair> *out) override;
+    void Query(AABB bounds, std::vector<ObjectHandle> *out) override;
+    void Refresh() override;
+    // Walks proxies from the ray origin in the direction of the ray along x
+    // and stops at proxies starting beyond `maxDistance`
+    void Raycast(const Ray &, float maxDistance, RayVisitor visit) const override;
+
+ private:
+    struct Proxy {
+        ObjectHandle handle;
+        AABB bounds;
+    };
+
+    void Sort();
+
+    std::vector<Proxy> m_Proxies;
+    // Largest size of proxy along x, bounds how far behind its min.x a proxy reaches
+    float m_MaxWidth = 0.f;
+    // slot of handle -> position in m_Proxies, -1 if there is no proxy
+    std::vector<int> m_HandleToProxy;
+};
+
+// Hashes bounds into cells of fixed size.
+// Works better than sweep and prune when a lot of objects share x coordinate.
+class UniformGrid : public Broadphase {
+ public:
+    explicit UniformGrid(float cellSize = BROADPHASE_CELL_SIZE);
+
+    void Update(ObjectHandle, AABB bounds) override;
+    void Remove(ObjectHandle) override;
+    void FindPairs(std::vector<BroadphasePair> *out) override;
+    void Query(AABB bounds, std::vector<ObjectHandle> *out) override;
+    void Refresh() override;
+    // Walks cells along the ray (3D-DDA) and stops at the first cell
+    // farther than `maxDistance`
+    void Raycast(const Ray &, float maxDistance, RayVisitor visit) const override;
+
+ private:
+    using CellKey = int64_t;
+
+    Vec3Int GetCell(Vec3 point) const;
+    CellKey GetKey(Vec3Int cell) const;
+    bool IsOversized(Vec3Int minCell, Vec3Int maxCell) const;
+    const AABB &GetBounds(ObjectHandle handle) const;
+    void Rebuild();
+
+    float m_CellSize;
+    // Indexed by slot of handle
+    std::vector<AABB> m_Bounds;
+    // slot of handle -> position in m_Handles, -1 if there is no proxy
+    std::vector<int> m_HandleToIndex;
+    std::vector<ObjectHandle> m_Handles;
+    std::unordered_map<CellKey, std::vector<ObjectHandle>> m_Cells;
+    // Proxies covering too many cells are tested against everything
+    std::vector<ObjectHandle> m_Oversized;
+    // Indexed by slot of handle
+    std::vector<bool> m_IsOversized;
+    // Cells holding at least one proxy lie between these
+    Vec3Int m_MinCell, m_MaxCell;
+    // Set when bounds changed since the grid was built
+    bool m_Dirty = true;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <variant>
 #include <optional>
 #include "geometry_primitives.hpp"
@@ -7,12 +8,35 @@
 #include "mesh.hpp"
 #include "manifold.hpp"
 
+// Static colliders never move. Sleeping ones are at rest until something
+// dynamic touches them. Pairs of colliders that both keep still can't
+// start colliding, so they are never tested. Rigid bodies of colliders
+// that are not dynamic act as infinite mass and are not integrated.
+// The engine only wakes sleeping colliders up, putting one to sleep
+// is up to the caller
+enum class ColliderMotion : uint8_t {
+    DYNAMIC,
+    STATIC,
+    SLEEPING,
+};
+
 struct Collider {
     std::variant<AABB, Sphere, OBB, Mesh *> shape;
+    // Bit per layer the collider belongs to
+    uint32_t layers = 1;
+    // Layers the collider collides with
+    uint32_t mask = ~0u;
+    ColliderMotion motion = ColliderMotion::DYNAMIC;
 
     static AABB GetDefaultAABB(Mesh*);
     static AABB GetDefaultAABB(Model* model);
+    // World-space bounds of the shape, used by broadphase
+    AABB GetBounds(Transform self);
     CollisionManifold Collide(Transform self, Collider *other, Transform otherTransform);
     bool Raycast(Transform self, Ray ray);
     std::optional<float> RaycastHit(Transform self, Ray ray);
+
+    // Whether the pair needs narrowphase at all: both masks have a layer of
+    // the other collider and at least one of them is dynamic
+    static bool CanCollide(const Collider &a, const Collider &b);
 };
@@ -45,4 +45,8 @@ bool CollidePrimitive(Ray, OBB);
 std::optional<float> CollisionPrimitive(Ray, Sphere);
 std::optional<float> CollisionPrimitive(Ray, AABB);
 std::optional<float> CollisionPrimitive(Ray, OBB);
+std::optional<float> CollisionPrimitive(Ray, Triangle);
+
+// Distance to the closest triangle hit by the ray, see MeshBVH::Raycast
+std::optional<float> CollisionMeshAt(Ray, Mesh *mesh, Transform transform);
 
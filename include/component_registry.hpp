@@ -0,0 +1,368 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <bitset>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "packed_array.hpp"
+#include "logger.hpp"
+#include "handle.hpp"
+#include "job_system.hpp"
+
+template<typename ...Ts>
+struct TypeList {};
+
+// Position of T in Ts. Fails to compile if T is not in the list
+template<typename T, typename ...Ts>
+struct TypeIndex;
+
+template<typename T, typename ...Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template<typename T, typename U, typename ...Ts>
+struct TypeIndex<T, U, Ts...> : std::integral_constant<size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+template<typename T>
+struct TypeIndex<T> {
+    static_assert(sizeof(T) == 0, "Type is not registered as a component");
+};
+
+// Range over objects having all of Ts, yields tuple(handle, Ts &...).
+// Created by ComponentRegistry::View. Iterates the smallest of the arrays
+// and looks the object up in the others, presence check and lookup are one
+// read per array. In grouped mode the arrays share dense indices, so
+// components are read by position without any lookups.
+//
+// The driving array is only known at run time, so the iterator checks per
+// object which arrays it reads by position. That makes the view 1.5-2x
+// slower than Each, which compiles the loop once per driving array (see
+// component_benchmark). The view is kept for loops off the hot path, such as
+// error reporting and building groups, where `break` and plain range-for
+// are worth more than the speed. Per-frame loops use Each or ParallelEach
+template<typename ...Ts>
+class ComponentView {
+ public:
+    class Iterator {
+     public:
+        // View is copied, so its fields stay in registers while iterating
+        Iterator(const ComponentView &view, int index) : m_View(view), m_Index(index) {
+            FindMatch();
+        }
+
+        std::tuple<ObjectHandle, Ts &...> operator*() const {
+            return {m_View.m_Handles[m_Index], *std::get<Ts *>(m_Current)...};
+        }
+
+        Iterator &operator++() {
+            m_Index++;
+            FindMatch();
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return m_Index != other.m_Index;
+        }
+
+     private:
+        // Array that drives iteration, as well as every array in grouped mode,
+        // is read by position. Others are looked up by handle
+        template<typename T>
+        T *FindComponent(ObjectHandle handle) const {
+            auto &array = m_View.template GetArray<T>();
+            if (m_View.IsPositional(array))
+                return &array.entries[m_Index];
+            return array.Find(handle);
+        }
+
+        // Moves m_Index to the first object having all of Ts
+        void FindMatch() {
+            for (; m_Index < m_View.m_Size; m_Index++) {
+                ObjectHandle handle = m_View.m_Handles[m_Index];
+                if (((std::get<Ts *>(m_Current) = FindComponent<Ts>(handle)) && ...))
+                    return;
+            }
+        }
+
+        ComponentView m_View;
+        int m_Index;
+        std::tuple<Ts *...> m_Current;
+    };
+
+    ComponentView(const ObjectHandle *handles, int size, bool grouped, PackedArray<Ts> *...arrays)
+        : m_Handles(handles), m_Size(size), m_Arrays(arrays...) {
+        m_Positional = 0;
+        int bit = 0;
+        ((m_Positional |= (grouped || handles == arrays->GetInternalEntries()) << bit++), ...);
+    }
+
+    Iterator begin() const {
+        return Iterator(*this, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(*this, m_Size);
+    }
+
+ private:
+    template<typename T>
+    PackedArray<T> &GetArray() const {
+        return *std::get<PackedArray<T> *>(m_Arrays);
+    }
+
+    template<typename T>
+    bool IsPositional(const PackedArray<T> &) const {
+        return m_Positional >> TypeIndex<T, Ts...>::value & 1;
+    }
+
+    const ObjectHandle *m_Handles;
+    int m_Size;
+    // Bit i is set when i-th array is read by position
+    unsigned m_Positional;
+    std::tuple<PackedArray<Ts> *...> m_Arrays;
+};
+
+template<typename List>
+class ComponentRegistry;
+
+// Stores one PackedArray per component type of the list.
+// Every object slot also has a signature: bit i is set when the object has
+// the i-th component of the list. Signatures are used to keep groups.
+//
+// Components must be added and removed through the registry, otherwise
+// signatures go out of sync with the arrays.
+template<typename ...Components>
+class ComponentRegistry<TypeList<Components...>> {
+ public:
+    using Signature = std::bitset<sizeof...(Components)>;
+
+    template<typename T>
+    using Array = PackedArray<T>;
+
+    template<typename T>
+    static constexpr size_t IndexOf = TypeIndex<T, Components...>::value;
+
+    template<typename ...Ts>
+    static Signature SignatureOf() {
+        Signature result;
+        (result.set(IndexOf<Ts>), ...);
+        return result;
+    }
+
+    template<typename T>
+    Array<T> &GetArray() {
+        return std::get<IndexOf<T>>(m_Arrays);
+    }
+
+    template<typename T>
+    bool Has(ObjectHandle handle) {
+        return Get<T>(handle) != nullptr;
+    }
+
+    // Returns nullptr if object has no such component or handle is stale
+    template<typename T>
+    T *Get(ObjectHandle handle) {
+        return handle >= 0 ? GetArray<T>().Find(handle) : nullptr;
+    }
+
+    // Constructs component from `args` in place, see PackedArray::Emplace
+    template<typename T, typename ...Args>
+    T &Add(ObjectHandle handle, Args &&...args) {
+        T *component = GetArray<T>().Emplace(handle, std::forward<Args>(args)...);
+        assert(component && "Adding component to invalid object");
+
+        int slot = GetHandleIndex(handle);
+        if (slot >= m_Signatures.size())
+            m_Signatures.resize(slot + 1);
+        m_Signatures[slot].set(IndexOf<T>);
+        for (auto &group : m_Groups) {
+            if (group.mask.test(IndexOf<T>))
+                EnterGroup<T>(&group, handle);
+        }
+        return GetArray<T>().GetData(handle);
+    }
+
+    template<typename T>
+    void Remove(ObjectHandle handle) {
+        if (!Has<T>(handle))
+            return;
+        for (auto &group : m_Groups) {
+            if (group.mask.test(IndexOf<T>))
+                LeaveGroup<T>(&group, handle);
+        }
+        GetArray<T>().RemoveData(handle);
+        m_Signatures[GetHandleIndex(handle)].reset(IndexOf<T>);
+    }
+
+    // Removes every registered component of the object
+    void RemoveAll(ObjectHandle handle) {
+        (Remove<Components>(handle), ...);
+    }
+
+    // Keeps arrays of Ts sorted so that objects having all of Ts come first
+    // and share the same internal index in every array. View<Ts...> with
+    // exactly these types then reads components by index without any lookups.
+    // A type can belong to one group only.
+    template<typename ...Ts>
+    void Group() {
+        static_assert(sizeof...(Ts) > 1, "Group requires at least two component types");
+        const Signature mask = SignatureOf<Ts...>();
+        for (auto &group : m_Groups) {
+            if (group.mask == mask)
+                return;
+            if ((group.mask & mask).any()) {
+                Logger::Error("Component type already belongs to another group");
+                return;
+            }
+        }
+        m_Groups.push_back(GroupData{mask, 0});
+
+        using First = std::tuple_element_t<0, std::tuple<Ts...>>;
+        std::vector<ObjectHandle> members;
+        for (auto [handle, first] : View<First>()) {
+            if ((m_Signatures[GetHandleIndex(handle)] & mask) == mask)
+                members.push_back(handle);
+        }
+        for (auto handle : members)
+            EnterGroup<First>(&m_Groups.back(), handle);
+    }
+
+    // Objects having all of Ts, see ComponentView.
+    // Components must not be added or removed while iterating.
+    template<typename ...Ts>
+    ComponentView<Ts...> View() {
+        static_assert(sizeof...(Ts) > 0, "View requires at least one component type");
+        const Signature mask = SignatureOf<Ts...>();
+        for (auto &group : m_Groups) {
+            if (group.mask != mask)
+                continue;
+            auto &first = std::get<0>(std::tie(GetArray<Ts>()...));
+            return ComponentView<Ts...>(first.GetInternalEntries(), group.size, true,
+                    &GetArray<Ts>()...);
+        }
+
+        const ObjectHandle *handles = nullptr;
+        int size = -1;
+        auto pickSmallest = [&](auto &array) {
+            if (size == -1 || array.GetSize() < size) {
+                size = array.GetSize();
+                handles = array.GetInternalEntries();
+            }
+        };
+        (pickSmallest(GetArray<Ts>()), ...);
+        return ComponentView<Ts...>(handles, size, false, &GetArray<Ts>()...);
+    }
+
+    // Calls f(handle, Ts &...) for every object having all of Ts.
+    // Same objects as View<Ts...>, but the loop is compiled separately for
+    // every array that can drive it, so it has no per-object dispatch.
+    // Components must not be added or removed from inside `f`.
+    // Returns number of objects `f` was called for.
+    template<typename ...Ts, typename F>
+    int Each(F f) {
+        return EachWith<Ts...>([](int count, const auto &body) { body(0, count); }, f);
+    }
+
+    // Same as Each, but objects are split in chunks run by `jobs` in parallel.
+    // `f` may only access components of the object it is called for.
+    template<typename ...Ts, typename F>
+    int ParallelEach(JobSystem *jobs, F f) {
+        return EachWith<Ts...>([jobs](int count, const auto &body) { jobs->ParallelFor(count, body); }, f);
+    }
+
+ private:
+    struct GroupData {
+        Signature mask;
+        // Members occupy internal positions [0, size) of every array of the group
+        int size;
+    };
+
+    // loop(count, body) calls body(begin, end) on ranges covering [0, count)
+    template<typename ...Ts, typename Loop, typename F>
+    int EachWith(const Loop &loop, F &f) {
+        static_assert(sizeof...(Ts) > 0, "Each requires at least one component type");
+        const Signature mask = SignatureOf<Ts...>();
+        for (auto &group : m_Groups) {
+            if (group.mask != mask)
+                continue;
+            auto &first = std::get<0>(std::tie(GetArray<Ts>()...));
+            loop(group.size, [&](int begin, int end) {
+                for (int i = begin; i < end; i++)
+                    f(first.GetFromInternal(i), GetArray<Ts>().entries[i]...);
+            });
+            return group.size;
+        }
+
+        const int smallest = std::min({GetArray<Ts>().GetSize()...});
+        bool done = false;
+        int visited = 0;
+        auto tryDriver = [&](auto *driverTag) {
+            using Driver = std::remove_pointer_t<decltype(driverTag)>;
+            if (done || GetArray<Driver>().GetSize() != smallest)
+                return;
+            done = true;
+            visited = EachDriven<Driver, Ts...>(loop, f);
+        };
+        (tryDriver(static_cast<Ts *>(nullptr)), ...);
+        return visited;
+    }
+
+    template<typename Driver, typename ...Ts, typename Loop, typename F>
+    int EachDriven(const Loop &loop, F &f) {
+        auto &driver = GetArray<Driver>();
+        std::atomic<int> visited{0};
+        loop(driver.GetSize(), [&](int begin, int end) {
+            int chunkVisited = 0;
+            for (int i = begin; i < end; i++) {
+                ObjectHandle handle = driver.GetFromInternal(i);
+                std::tuple<Ts *...> components{FindInDriven<Driver, Ts>(handle, i)...};
+                if ((std::get<Ts *>(components) && ...)) {
+                    f(handle, *std::get<Ts *>(components)...);
+                    chunkVisited++;
+                }
+            }
+            visited.fetch_add(chunkVisited, std::memory_order_relaxed);
+        });
+        return visited.load(std::memory_order_relaxed);
+    }
+
+    template<typename Driver, typename T>
+    T *FindInDriven(ObjectHandle handle, int index) {
+        if constexpr (std::is_same_v<Driver, T>)
+            return &GetArray<T>().entries[index];
+        else
+            return GetArray<T>().Find(handle);
+    }
+
+    // Moves component U of the object to `index` if U belongs to the group
+    template<typename U>
+    void MoveInGroup(const GroupData &group, ObjectHandle handle, int index) {
+        if (group.mask.test(IndexOf<U>))
+            GetArray<U>().MoveToInternal(handle, index);
+    }
+
+    // T is any type of the group that the object has
+    template<typename T>
+    void EnterGroup(GroupData *group, ObjectHandle handle) {
+        if ((m_Signatures[GetHandleIndex(handle)] & group->mask) != group->mask)
+            return;
+        if (GetArray<T>().GetInternalIndex(handle) < group->size)
+            return;
+        (MoveInGroup<Components>(*group, handle, group->size), ...);
+        group->size++;
+    }
+
+    template<typename T>
+    void LeaveGroup(GroupData *group, ObjectHandle handle) {
+        if (GetArray<T>().GetInternalIndex(handle) >= group->size)
+            return;
+        group->size--;
+        (MoveInGroup<Components>(*group, handle, group->size), ...);
+    }
+
+    std::tuple<Array<Components>...> m_Arrays;
+    // Indexed by slot of the handle
+    std::vector<Signature> m_Signatures;
+    std::vector<GroupData> m_Groups;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "manifold.hpp"
+#include "handle.hpp"
+
+struct Contact {
+    ObjectHandle a, b;
+    CollisionManifold manifold;
+};
+
+// Holds manifolds of colliding pairs for the current frame.
+// Contacts are kept in a vector sorted by (a, b), so lookups are binary searches
+// and memory is proportional to the number of touching pairs.
+class ContactStore {
+ public:
+    void Clear();
+
+    // Stores contact in both directions. Normal is flipped for (b, a)
+    void Add(ObjectHandle a, ObjectHandle b, CollisionManifold manifold);
+
+    // Sorts contacts. Should be called after all contacts of the frame are added
+    void Finalize();
+
+    // Returns nullptr if objects don't touch
+    const CollisionManifold *Find(ObjectHandle a, ObjectHandle b) const;
+
+    // Range of contacts having `a` as the first object
+    std::pair<const Contact *, const Contact *> GetContacts(ObjectHandle a) const;
+
+    const Contact *begin() const;
+    const Contact *end() const;
+
+ private:
+    static uint64_t GetKey(ObjectHandle a, ObjectHandle b);
+
+    std::vector<uint64_t> m_Keys;
+    std::vector<Contact> m_Contacts;
+};
@@ -5,6 +5,10 @@
 #include <map>
 #include <set>
 #include <bitset>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <type_traits>
 #include "collider.hpp"
 #include "collisions.hpp"
 #include "render_data.hpp"
@@ -27,19 +31,50 @@
 #include "manifold.hpp"
 #include "skeletal_animations_manager.hpp"
 #include "skeletal_animation_data.hpp"
+#include "handle.hpp"
+#include "broadphase.hpp"
+#include "narrowphase.hpp"
+#include "contact_store.hpp"
+#include "component_registry.hpp"
+#include "backend.hpp"
+#include "job_system.hpp"
+#include "render_queue.hpp"
+#include "frustum.hpp"
+#include "asset_manager.hpp"
+#include "system_scheduler.hpp"
+#include "user_config.hpp"
 
 extern Input *s_Input;
 
 class Object;
 class Behaviour;
 
-using ObjectHandle = int;
+enum class EngineMode {
+    WINDOWED,
+    // No window, GL or audio, see Backend. Simulation is advanced with Step
+    HEADLESS,
+};
 
-const ObjectHandle ROOT = -1;
+// Every component type stored by Engine. Removal and iteration are generated
+// from this list, so a new component only has to be added here
+using ComponentTypes = TypeList<
+    Transform,
+    Model,
+    Collider,
+    RigidBody,
+    Animation,
+    Image,
+    Text,
+    SkeletalAnimationsManager,
+    Sound,
+    PointLight,
+    DirLight,
+    SpotLight,
+    Behaviour *>;
 
 class Engine {
  public:
-    Engine();
+    explicit Engine(EngineMode mode = EngineMode::WINDOWED);
     ~Engine();
 
     Transform *GetTransform(ObjectHandle);
@@ -72,8 +107,57 @@ class Engine {
 
     template<typename T>
     T &AddBehaviour(ObjectHandle id, T *t) {
-        m_Behaviours.SetData(id, t);
-        return static_cast<T &>(*m_Behaviours.GetData(id));
+        return static_cast<T &>(*Add<Behaviour *>(id, t));
+    }
+
+    // Generic component access, T must be listed in ComponentTypes
+    template<typename T>
+    T *Get(ObjectHandle handle) {
+        Touch<T>(handle);
+        return m_Components.Get<T>(handle);
+    }
+
+    // Constructs component in place from `args`.
+    // Component of a removed object is built aside and never enters the registry,
+    // so a stale handle can't take the slot from the object that reuses it
+    template<typename T, typename ...Args>
+    T &Add(ObjectHandle handle, Args &&...args) {
+        if (!IsObjectValid(handle)) {
+            Logger::Error("ENGINE::ADDING_COMPONENT_TO_REMOVED_OBJECT %d", handle);
+            static std::optional<T> s_Discarded;
+            if constexpr (std::is_constructible_v<T, Args...>)
+                return s_Discarded.emplace(std::forward<Args>(args)...);
+            else
+                return s_Discarded.emplace(T{std::forward<Args>(args)...});
+        }
+        Touch<T>(handle);
+        return m_Components.Add<T>(handle, std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void Remove(ObjectHandle handle) {
+        if (!m_Components.Has<T>(handle))
+            return;
+        if constexpr (std::is_same_v<T, Collider>)
+            m_Broadphase->Remove(handle);
+        Touch<T>(handle);
+        m_Components.Remove<T>(handle);
+    }
+
+    // Range of tuple(handle, Ts &...) over objects having all of Ts.
+    // Slower than Each, see ComponentView
+    template<typename ...Ts>
+    auto View() {
+        TouchAll<Ts...>();
+        return m_Components.View<Ts...>();
+    }
+
+    // Calls f(handle, Ts &...) for every object having all of Ts.
+    // Returns number of such objects
+    template<typename ...Ts, typename F>
+    int Each(F f) {
+        TouchAll<Ts...>();
+        return m_Components.Each<Ts...>(f);
     }
 
     void RemoveObject(ObjectHandle);
@@ -92,49 +176,169 @@ class Engine {
     bool Collide(ObjectHandle, ObjectHandle);
     std::vector<Object> CollideAll(ObjectHandle);
 
+    // Closest object whose collider is hit by the ray. Colliders added or
+    // moved since the last physics step are brought to the broadphase first,
+    // so rays see current transforms. Changes made through Transform or
+    // Collider pointers fetched before the previous raycast of the same
+    // frame are not seen until the next frame
     std::optional<ObjectHandle> GlobalRaycast(Ray ray);
+    // Casts rays of the batch in parallel, (*out)[i] is the hit of rays[i]
+    void GlobalRaycast(const std::vector<Ray> &rays, std::vector<std::optional<ObjectHandle>> *out);
+    // Moves every collider searched by GlobalRaycast to current transforms,
+    // physics steps do it on their own
+    void SyncColliders();
+
+    // Replaces collision broadphase. SweepAndPrune is used by default
+    void SetBroadphase(std::unique_ptr<Broadphase>);
+
+    // Physics is simulated in fixed steps of 1 / ticksPerSecond seconds
+    void SetPhysicsTickRate(float ticksPerSecond);
+
+    // Number of threads helping the main one to update objects.
+    // Negative starts one per hardware thread, 0 updates everything
+    // on the main thread in a fixed order, which is handy for debugging.
+    // Must not be called during update
+    void SetWorkerCount(int);
 
     Camera* SwitchCamera(Camera* newCamera);
+    // Draw calls and state changes of the last rendered frame
+    const RenderStats &GetRenderStats() const;
+    // Polls input, updates and renders until the window is closed. Windowed mode only
     void Run();
+    // Advances simulation by deltaTime seconds without polling input or rendering
+    void Step(float deltaTime);
     Input m_Input;
     Camera* camera;
 
  private:
     void Render(int, int);
+    // Packs light components into the lights uniform buffer
+    void UploadLights();
     void updateObjects(float);
 
-    GLFWwindow *m_Window;
+    void SyncCollider(ObjectHandle, Collider &);
+    // Syncs only colliders of m_MovedColliders, skipped if no transform
+    // or collider could have changed since the last sync
+    void SyncMovedColliders();
 
-    // Components storage
+    // Records access that may change what GlobalRaycast sees
     template<typename T>
-    using ComponentArray = PackedArray<T, MAX_OBJECT_COUNT>;
+    void Touch(ObjectHandle handle) {
+        if constexpr (std::is_same_v<T, Transform>) {
+            m_TransformsTouched = true;
+        } else if constexpr (std::is_same_v<T, Collider>) {
+            m_TransformsTouched = true;
+            m_MovedColliders.push_back(handle);
+        }
+    }
+    template<typename ...Ts>
+    void TouchAll() {
+        if constexpr ((std::is_same_v<Ts, Collider> || ...))
+            m_AllCollidersTouched = true;
+        if constexpr ((std::is_same_v<Ts, Transform> || ...))
+            m_TransformsTouched = true;
+    }
+
+    // Systems run by updateObjects, see the constructor for their access
+    void UpdateCollisions();
+    // Broadphase must be refreshed before
+    std::optional<ObjectHandle> CastRay(const Ray &ray);
+    void ResolveCollisions(float);
+    void UpdateAnimations(float);
+    void UpdateSkeletalAnimations(float);
+    void UpdateRigidBodies(float);
+    void UpdateSounds();
+    void UpdateBehaviours(float);
 
-    ComponentArray<Transform> m_Transforms;
-    ComponentArray<Model> m_Models;
-    ComponentArray<Collider> m_Colliders;
-    ComponentArray<RigidBody> m_RigidBodies;
-    ComponentArray<Animation> m_Animations;
-    ComponentArray<Image> m_Images;
-    ComponentArray<Text> m_Texts;
-    ComponentArray<SkeletalAnimationsManager> m_SkeletalAnimationsManagers;
-    ComponentArray<Sound> m_Sounds;
+    ObjectHandle AllocateHandle();
+    void FreeHandle(ObjectHandle);
 
-    ComponentArray<PointLight> m_PointLights;
-    ComponentArray<DirLight> m_DirLights;
-    ComponentArray<SpotLight> m_SpotLights;
+    void UpdateHierarchyOrder();
+    // Recomputes world transforms of changed subtrees
+    void UpdateGlobalTransforms();
+    // Saves transforms of rigid bodies before a physics step
+    void SavePhysicsState();
+    // Computes m_RenderMatrices, moving rigid bodies `alpha` of a step
+    // from their previous transforms towards the current ones
+    void InterpolateRenderMatrices(float alpha);
 
-    ComponentArray<Behaviour *> m_Behaviours;
+    GLFWwindow *m_Window = nullptr;
+    bool m_Headless;
+    // Uniform buffer bound to LIGHTS_UNIFORM_BINDING, shared by all shader programs
+    unsigned int m_LightsBuffer = 0;
+    RenderQueue m_RenderQueue;
+    // Objects tested against the view frustum on the current frame
+    std::vector<Model *> m_CullModels;
+    std::vector<const Mat4 *> m_CullWorlds;
+    BoxArray m_CullBoxes;
+    std::vector<uint8_t> m_CullVisible;
 
-    int m_ObjectCount;
+    // Components storage
+    ComponentRegistry<ComponentTypes> m_Components;
+
+    std::unique_ptr<JobSystem> m_Jobs;
+    // Run once per fixed physics step
+    SystemScheduler<ComponentTypes> m_PhysicsSystems;
+    // Run once per frame after physics
+    SystemScheduler<ComponentTypes> m_Systems;
+
+    float m_PhysicsStep = 1.f / PHYSICS_TICK_RATE;
+    // Elapsed time not simulated by physics yet, less than a step between frames
+    float m_PhysicsAccumulator = 0.f;
+    // Local transforms of rigid bodies before the last physics step, indexed by slot.
+    // Rendering interpolates between them and the current ones
+    std::vector<Transform> m_PreviousTransforms;
+    // Handle the previous transform was saved for, indexed by slot
+    std::vector<ObjectHandle> m_PreviousHandles;
+    // World matrices used for rendering, in hierarchy order
+    std::vector<Mat4> m_RenderMatrices;
+    // Whether render matrix differs from the world one, in hierarchy order
+    std::vector<bool> m_RenderInterpolated;
+
+    // Generation of every object slot, see handle.hpp
+    std::vector<int> m_Generations;
+    // Slots of removed objects, reused by NewObject
+    std::vector<int> m_FreeSlots;
+    // Indexed by slot
     std::vector<std::string> m_Names;
     std::map<std::string, std::vector<ObjectHandle>> m_NamesToHandles;
 
     // Hierarchy tree
-    PackedArray<ObjectHandle, MAX_OBJECT_COUNT> m_Parents;
-    PackedArray<std::vector<ObjectHandle>, MAX_OBJECT_COUNT> m_Children;
+    PackedArray<ObjectHandle> m_Parents;
+    PackedArray<std::vector<ObjectHandle>> m_Children;
+
+    // World transforms cache. Arrays are stored in hierarchy order,
+    // so parents are always updated before their children
+    bool m_HierarchyChanged = true;
+    std::vector<ObjectHandle> m_HierarchyOrder;
+    // Index of parent in hierarchy order, -1 for roots
+    std::vector<int> m_HierarchyParent;
+    // Slot of handle -> index in hierarchy order
+    std::vector<int> m_HandleToHierarchy;
+    std::vector<Mat4> m_WorldMatrices;
+    std::vector<Transform> m_GlobalTransforms;
+    // Whether object has transform and cached value is valid
+    std::vector<bool> m_HasWorld;
+    // Whether world transform changed during current update
+    std::vector<bool> m_WorldChanged;
+
+    // Manifolds of pairs colliding on the last frame
+    ContactStore m_Contacts;
 
-    // Collision cache
-    // TODO(theblek): Make this a binary search tree
-    // Or just an ordered array and do binary search. Should be fast enough.
-    std::vector<std::vector<CollisionManifold>> m_CollideCache;
+    std::unique_ptr<Broadphase> m_Broadphase;
+    // Pairs with overlapping bounds found on the last frame,
+    // except those Collider::CanCollide rejects
+    std::vector<BroadphasePair> m_CollisionPairs;
+    Narrowphase m_Narrowphase;
+    // Narrowphase result of every pair of m_CollisionPairs
+    std::vector<CollisionManifold> m_PairManifolds;
+    // Global transforms of colliders for the current frame, indexed by slot
+    std::vector<Transform> m_ColliderTransforms;
+    // Colliders added or whose world transform changed since the broadphase
+    // was synced. May hold duplicates and handles of removed objects
+    std::vector<ObjectHandle> m_MovedColliders;
+    // Transforms or hierarchy may have changed since the broadphase was synced
+    bool m_TransformsTouched = true;
+    // Colliders were accessed in bulk, every one has to be synced
+    bool m_AllCollidersTouched = true;
 };
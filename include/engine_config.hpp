@@ -19,21 +19,63 @@
 // textures
 #define MAX_COUNT_TEXTURE           16
 
+// assets
+// Baked model is looked up next to the model file, at its path with this appended
+#define BAKED_MODEL_EXTENSION       ".bmdl"
+// Threads reading and decoding async loads, 0 loads them on the calling thread
+#define ASSET_LOADER_THREADS        1
+// Seconds per frame spent on GPU uploads of async loads, at least one upload runs
+#define ASSET_UPLOAD_BUDGET         0.002
+// Vertex buffers use quantized layouts, see VertexLayout. 0 uploads Vertex as it is
+#define COMPACT_VERTICES            1
+
 // engine
 #define EPS                         0.001f
 #define FPS_SHOWING_INTERVAL        0.5f
-#define MAX_OBJECT_COUNT            1000
+// Frame pacer yields instead of sleeping for the last seconds of a frame,
+// as sleep may overshoot
+#define FRAME_PACER_YIELD_TIME      0.002
 #define MAX_BONES                   100
 
+// lights
+// Sizes of light arrays in the uniform block, must match standart.fshader.
+// Lights beyond these are not rendered
+#define MAX_POINT_LIGHTS            10
+#define MAX_SPOT_LIGHTS             3
+#define MAX_DIR_LIGHTS              1
+#define LIGHTS_UNIFORM_BLOCK        "Lights"
+#define LIGHTS_UNIFORM_BINDING      0
+
+// instancing
+// Programs having this attribute are drawn instanced, it takes this location and three following ones
+#define INSTANCE_MATRIX_ATTRIBUTE   "instanceModel"
+#define INSTANCE_MATRIX_LOCATION    5
+
 // input
 #define MAX_VALID_KEY               350
 
+// jobs
+// -1 starts a worker per hardware thread, 0 runs everything on the main thread
+#define JOB_WORKER_COUNT            -1
+#define JOB_QUEUE_CAPACITY          1024
+// Parallel loops are split in at most this many chunks per thread
+#define JOB_CHUNKS_PER_THREAD       4
+#define JOB_MIN_CHUNK_SIZE          64
+
 // Math
 #define DOWN                        Vec3(0, -1, 0)
 
 
 // Collisions
 #define EJECTION_RATIO              3
+#define BROADPHASE_CELL_SIZE        4.0f
+// Proxies spanning more cells than this skip the grid
+#define BROADPHASE_MAX_CELLS        512
+// Mesh collider hierarchy: SAH bins per split and triangles per leaf
+#define BVH_BIN_COUNT               12
+#define BVH_MAX_LEAF_TRIANGLES      4
+// Deeper nodes are split in halves. Hierarchy depth is at most twice this
+#define BVH_SAH_DEPTH               32
 
 
 // rigid body
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include <ft2build.h>
@@ -9,7 +10,8 @@
 
 class Font {
  private:
-    ShaderProgram m_ShaderProgram;
+    // Shared by every font and text
+    std::shared_ptr<ShaderProgram> m_ShaderProgram;
     unsigned int m_VAO, m_VBO;
     struct Character {
        unsigned int TextureID;  // ID handle of the glyph texture
@@ -20,6 +22,7 @@ class Font {
     Character Characters[128];
 
  public:
+    // Prefer AssetManager::LoadFont, which loads every font file and size once
     Font(std::string, unsigned int);
     void RenderText(std::string, float, float, float, glm::vec3);
 };
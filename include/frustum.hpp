@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "math_types.hpp"
+#include "geometry_primitives.hpp"
+
+// Boxes given by centers and half extents. Coordinates are stored in
+// separate arrays, so Frustum::Cull runs over them with vector instructions
+struct BoxArray {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    void Clear();
+    // Bounds of `local` box transformed by `matrix`
+    void Add(const AABB &local, const Mat4 &matrix);
+    int GetSize() const;
+};
+
+// Planes of the camera view volume. Point p is inside of plane i
+// when normalX[i] * p.x + normalY[i] * p.y + normalZ[i] * p.z + offset[i] >= 0.
+// Planes are not normalized, only signs of distances are used
+struct Frustum {
+    float normalX[6], normalY[6], normalZ[6], offset[6];
+
+    // Extracts planes from projection * view matrix
+    static Frustum FromMatrix(const Mat4 &viewProjection);
+
+    // False only if box is outside of the frustum.
+    // Boxes near corners may pass while being outside
+    bool Intersects(const AABB &) const;
+
+    // Sets (*visible)[i] to whether i-th box intersects the frustum.
+    // Returns number of boxes outside
+    int Cull(const BoxArray &, std::vector<uint8_t> *visible) const;
+};
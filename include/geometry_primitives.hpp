@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <limits>
 #include <vector>
 #include "transform.hpp"
 #include "math_types.hpp"
@@ -23,16 +25,37 @@ struct AABB {
     float Distance2(Vec3);
     AABB PrevState(Vec3, float);
 
-    AABB Transformed(Transform);
+    AABB Transformed(const Transform &) const;
+    // Box containing this one transformed by any affine `matrix`
+    AABB TransformedBounds(const Mat4 &matrix) const;
 
-    std::vector<Vec3> GetVertices();
-    std::vector<Line> GetEdges();
-    std::vector<Plane> GetPlanes();
+    std::array<Vec3, 8> GetVertices();
+    std::array<Line, 12> GetEdges();
+    std::array<Plane, 6> GetPlanes();
 
     bool IsPointIn(Vec3);
 
 };
 
+// 1 / direction with zero components replaced by tiny ones, so slab tests need no special cases
+inline Vec3 InverseDirection(Vec3 direction) {
+    Vec3 res;
+    for (int i = 0; i < 3; i++)
+        res[i] = 1.f / (direction[i] != 0.f ? direction[i] : 1e-30f);
+    return res;
+}
+
+// Distance in units of the direction at which ray enters `box`, 0 if it starts inside.
+// Returns infinity if the ray misses the box or enters it farther than `maxDistance`
+inline float RayEntry(const AABB &box, Vec3 origin, Vec3 inverseDirection, float maxDistance) {
+    Vec3 t0 = (box.min - origin) * inverseDirection;
+    Vec3 t1 = (box.max - origin) * inverseDirection;
+    Vec3 near = glm::min(t0, t1), far = glm::max(t0, t1);
+    float entry = glm::max(glm::max(near.x, near.y), glm::max(near.z, 0.f));
+    float exit = glm::min(glm::min(far.x, far.y), glm::min(far.z, maxDistance));
+    return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+
 struct Sphere {
     Vec3 center;
     float radius;
@@ -40,7 +63,7 @@ struct Sphere {
     Vec3 ClosestPoint(Vec3);
 
     Sphere PrevState(Vec3, float);
-    Sphere Transformed(Transform);
+    Sphere Transformed(const Transform &) const;
 };
 
 struct Triangle {
@@ -52,7 +75,7 @@ struct Triangle {
     Interval GetInterval(Vec3 axis);
     Vec3 ClosestPoint(Vec3);
     float Distance2(Vec3);
-    Triangle Transformed(Transform);
+    Triangle Transformed(const Transform &) const;
 };
 
 struct Ray {
@@ -81,13 +104,13 @@ struct OBB {
     Vec3 ClosestPoint(Vec3);
     float Distance2(Vec3);
 
-    std::vector<Vec3> GetVertices();
-    std::vector<Line> GetEdges();
-    std::vector<Plane> GetPlanes();
+    std::array<Vec3, 8> GetVertices();
+    std::array<Line, 12> GetEdges();
+    std::array<Plane, 6> GetPlanes();
 
     bool IsPointIn(Vec3);
 
-    OBB Transformed(Transform);
+    OBB Transformed(const Transform &) const;
 };
 
 struct Line {
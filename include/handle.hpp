@@ -0,0 +1,25 @@
+#pragma once
+
+// Low HANDLE_INDEX_BITS bits of a handle are the object slot, the rest is
+// the generation of the slot. Slots are reused after objects are removed,
+// generation tells handles of removed objects from the new ones.
+using ObjectHandle = int;
+
+const ObjectHandle ROOT = -1;
+
+const int HANDLE_INDEX_BITS = 20;
+const int HANDLE_INDEX_MASK = (1 << HANDLE_INDEX_BITS) - 1;
+// One bit less, so valid handles are never negative
+const int HANDLE_GENERATION_MASK = (1 << (31 - HANDLE_INDEX_BITS)) - 1;
+
+inline int GetHandleIndex(ObjectHandle handle) {
+    return handle & HANDLE_INDEX_MASK;
+}
+
+inline int GetHandleGeneration(ObjectHandle handle) {
+    return (handle >> HANDLE_INDEX_BITS) & HANDLE_GENERATION_MASK;
+}
+
+inline ObjectHandle MakeHandle(int index, int generation) {
+    return ((generation & HANDLE_GENERATION_MASK) << HANDLE_INDEX_BITS) | index;
+}
@@ -1,14 +1,17 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include "shaders.hpp"
+#include "texture.hpp"
 
 
 class Image {
  private:
-    ShaderProgram m_ShaderProgram;
+    // Both are shared by every image of the same file, see AssetManager
+    std::shared_ptr<ShaderProgram> m_ShaderProgram;
+    std::shared_ptr<const TextureAsset> m_Texture;
     unsigned int m_VAO, m_VBO;
-    unsigned int m_TextureID;
     float m_RelX, m_RelY;
     float m_Scale;
     int m_Height, m_Width;
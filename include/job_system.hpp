@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "engine_config.hpp"
+
+// Pool of worker threads running small jobs.
+// Every worker owns a queue: it takes jobs from the back of its own queue
+// and steals from the front of the others when it runs out of work.
+// Threads that are not workers push to a shared queue.
+// A thread waiting for jobs runs queued jobs meanwhile, so jobs may wait
+// for other jobs without deadlocks.
+//
+// With zero workers every job runs on the spot in the calling thread,
+// which gives deterministic single-threaded execution for debugging.
+class JobSystem {
+ public:
+    // Job runs function(data, begin, end)
+    using Function = void (*)(void *data, int begin, int end);
+
+    // Number of unfinished jobs started with the counter
+    struct Counter {
+        std::atomic<int> pending{0};
+    };
+
+    // Negative count starts one worker per hardware thread except the calling one
+    explicit JobSystem(int workerCount = JOB_WORKER_COUNT);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    int GetWorkerCount() const;
+
+    // Schedules the job. Counter may be nullptr
+    void Run(Counter *, Function, void *data, int begin = 0, int end = 0);
+
+    // Runs one queued job if there is any
+    bool RunPending();
+
+    // Runs queued jobs until every job of the counter is finished
+    void Wait(Counter *);
+
+    // Calls body(begin, end) on chunks of [0, count) in parallel and waits for them.
+    // Chunks are at least JOB_MIN_CHUNK_SIZE long
+    template<typename F>
+    void ParallelFor(int count, const F &body) {
+        int chunks = std::min((GetWorkerCount() + 1) * JOB_CHUNKS_PER_THREAD,
+                              count / JOB_MIN_CHUNK_SIZE);
+        if (chunks <= 1 || GetWorkerCount() == 0) {
+            if (count > 0)
+                body(0, count);
+            return;
+        }
+
+        auto invoke = [](void *data, int begin, int end) {
+            (*static_cast<const F *>(data))(begin, end);
+        };
+        Counter counter;
+        int chunkSize = (count + chunks - 1) / chunks;
+        for (int begin = chunkSize; begin < count; begin += chunkSize)
+            Run(&counter, invoke, const_cast<F *>(&body), begin, std::min(begin + chunkSize, count));
+        body(0, chunkSize);
+        Wait(&counter);
+    }
+
+ private:
+    struct Job {
+        Function function;
+        void *data;
+        int begin, end;
+        Counter *counter;
+    };
+
+    // Ring buffer of fixed capacity, jobs do not allocate
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Job> jobs;
+        int head = 0;
+        int size = 0;
+    };
+
+    void Execute(const Job &);
+    bool Push(Queue *, const Job &);
+    bool PopBack(Queue *, Job *);
+    bool PopFront(Queue *, Job *);
+    // Queue of the calling thread, shared queue for non-workers
+    int GetQueueIndex() const;
+    void WorkerLoop(int queueIndex);
+
+    // m_Queues[0] is shared, m_Queues[i + 1] belongs to i-th worker
+    std::vector<std::unique_ptr<Queue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+
+    std::atomic<int> m_Queued{0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeUp;
+    bool m_Quit = false;
+};
@@ -2,6 +2,7 @@
 
 #include <variant>
 #include "math_types.hpp"
+#include "engine_config.hpp"
 
 struct Light {
     Vec3 ambient;
@@ -70,3 +71,52 @@ struct SpotLight : Light {
 };
 
 typedef std::variant<PointLight *, SpotLight *, DirLight *> LightSource;
+
+// Layout of the lights uniform block (std140), filled by the engine once per frame.
+// Every Vec3 is followed by a float, so fields are packed in 16 byte rows
+struct PointLightData {
+    Vec3 position;
+    float constDistCoeff;
+    Vec3 ambient;
+    float linearDistCoeff;
+    Vec3 diffuse;
+    float quadraticDistCoeff;
+    Vec3 specular;
+    float padding;
+};
+
+struct SpotLightData {
+    Vec3 position;
+    float cutOff;
+    Vec3 direction;
+    float outerCutOff;
+    Vec3 ambient;
+    float constDistCoeff;
+    Vec3 diffuse;
+    float linearDistCoeff;
+    Vec3 specular;
+    float quadraticDistCoeff;
+};
+
+struct DirLightData {
+    Vec3 direction;
+    float padding0;
+    Vec3 ambient;
+    float padding1;
+    Vec3 diffuse;
+    float padding2;
+    Vec3 specular;
+    float padding3;
+};
+
+struct LightsBlock {
+    PointLightData pointLights[MAX_POINT_LIGHTS];
+    SpotLightData spotLights[MAX_SPOT_LIGHTS];
+    DirLightData dirLights[MAX_DIR_LIGHTS];
+    int pointLightCount;
+    int spotLightCount;
+    int dirLightCount;
+};
+
+static_assert(sizeof(PointLightData) == 64 && sizeof(SpotLightData) == 80 && sizeof(DirLightData) == 64,
+              "Light data must follow std140 layout");
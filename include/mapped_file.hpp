@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Read-only file mapped into memory. Pages are read by the OS on first
+// access, so opening is cheap and data is not copied into the process.
+// Mapping is page aligned and lives as long as the object
+class MappedFile {
+ public:
+    // Returns nullptr if the file can't be opened or is empty
+    static std::shared_ptr<const MappedFile> Open(const std::string &path);
+
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *GetData() const;
+    size_t GetSize() const;
+    // Reads the whole file in, so later accesses don't wait for the disk.
+    // Lets a loader thread take the I/O off the thread using the data
+    void Prefetch() const;
+
+ private:
+    MappedFile() = default;
+
+    const unsigned char *m_Data = nullptr;
+    size_t m_Size = 0;
+};
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include "transform.hpp"
+#include "geometry_primitives.hpp"
+#include "mesh_bvh.hpp"
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -18,6 +20,7 @@ class Mesh {
  private:
     std::vector<Vertex> points;
     std::vector<unsigned int> indices;
+    MeshBVH bvh;
 
  public:
     /* Constructors */
@@ -35,6 +38,11 @@ class Mesh {
     int getLenIndices();
     int getLenArrPoints();
 
+    // Hierarchy over triangles, kept up to date by the setters
+    const MeshBVH &GetBVH() const;
+    // Triangle number `index` with vertices transformed by `matrix`
+    Triangle GetTriangle(int index, const Mat4 &matrix) const;
+
     static Mesh *GetSphere();
     static Mesh *GetCube();
 
@@ -42,9 +50,11 @@ class Mesh {
     void setPoints(const std::vector<Vertex>& points);
     void setIndices(const std::vector<unsigned int>& indices);
     void setDefaultIndices();
+    // Must be called after points or indices are changed through getters
+    void UpdateBVH();
 
     // Mesh Transformed(Transform tranform);
 
-     Vec3 ClosestPoint(Vec3 point, Transform transform);
-     Vec3 CollisionNormal(Vec3 point, Transform tranform);
+    Vec3 ClosestPoint(Vec3 point, Transform transform);
+    Vec3 CollisionNormal(Vec3 point, Transform tranform);
 };
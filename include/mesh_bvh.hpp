@@ -0,0 +1,189 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "math_types.hpp"
+#include "geometry_primitives.hpp"
+#include "broadphase.hpp"
+#include "engine_config.hpp"
+
+struct Vertex;
+
+// Bounding volume hierarchy over triangles of a mesh in its local space.
+// Built once with binned surface area heuristic, queries bring the probe
+// to local space of the mesh, so the mesh itself is never transformed.
+// Nodes are stored depth first: left child goes right after its parent.
+class MeshBVH {
+ public:
+    struct Node {
+        AABB bounds;
+        // Right child of inner node, first entry of triangle list for leaf
+        int offset;
+        // Triangles of leaf, 0 for inner node
+        int count;
+    };
+
+    // Triangle i is made of vertices indices[3 * i], indices[3 * i + 1], indices[3 * i + 2]
+    void Build(const Vertex *points, const unsigned int *indices, int indexCount);
+    void Clear();
+
+    bool IsEmpty() const;
+    // Bounds of the whole mesh. Must not be empty
+    const AABB &GetBounds() const;
+    int GetNodeCount() const;
+
+    // Calls visit(triangle) for triangles whose bounds overlap `box`.
+    // Stops and returns true as soon as visit returns true
+    template<typename F>
+    bool Query(const AABB &box, F visit) const {
+        if (m_Nodes.empty())
+            return false;
+        int stack[MAX_DEPTH + 1];
+        int size = 0;
+        stack[size++] = 0;
+        while (size > 0) {
+            int index = stack[--size];
+            const Node &node = m_Nodes[index];
+            if (!Overlap(node.bounds, box))
+                continue;
+            if (node.count == 0) {
+                stack[size++] = node.offset;
+                stack[size++] = index + 1;
+                continue;
+            }
+            for (int i = node.offset; i < node.offset + node.count; i++) {
+                if (visit(m_Triangles[i]))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls visit(triangleOfA, triangleOfB) for pairs with overlapping bounds.
+    // `bToA` maps local space of `b` to local space of `a`.
+    // Stops and returns true as soon as visit returns true
+    template<typename F>
+    static bool QueryPairs(const MeshBVH &a, const MeshBVH &b, const Mat4 &bToA, F visit) {
+        if (a.m_Nodes.empty() || b.m_Nodes.empty())
+            return false;
+        struct Pair {
+            int a, b;
+        };
+        // Every step replaces a pair with two pairs one level deeper
+        Pair stack[2 * MAX_DEPTH + 1];
+        int size = 0;
+        stack[size++] = Pair{0, 0};
+        while (size > 0) {
+            Pair pair = stack[--size];
+            const Node &nodeA = a.m_Nodes[pair.a];
+            const Node &nodeB = b.m_Nodes[pair.b];
+            if (!Overlap(nodeA.bounds, nodeB.bounds.TransformedBounds(bToA)))
+                continue;
+
+            bool leafA = nodeA.count > 0, leafB = nodeB.count > 0;
+            if (leafA && leafB) {
+                for (int i = nodeA.offset; i < nodeA.offset + nodeA.count; i++) {
+                    for (int j = nodeB.offset; j < nodeB.offset + nodeB.count; j++) {
+                        if (visit(a.m_Triangles[i], b.m_Triangles[j]))
+                            return true;
+                    }
+                }
+                continue;
+            }
+            // Descend into the bigger node, so both sides shrink at the same pace
+            if (leafB || (!leafA && Area(nodeA.bounds) >= Area(nodeB.bounds))) {
+                stack[size++] = Pair{nodeA.offset, pair.b};
+                stack[size++] = Pair{pair.a + 1, pair.b};
+            } else {
+                stack[size++] = Pair{pair.a, nodeB.offset};
+                stack[size++] = Pair{pair.a, pair.b + 1};
+            }
+        }
+        return false;
+    }
+
+    // Visits triangles closest first, skipping those that can not be closer
+    // than the best one seen. lowerBound(nodeBounds) is a lower bound of
+    // the distance to any triangle inside, visit(triangle) is the distance
+    // to the triangle. Distances may be of any monotonic kind, e.g. squared
+    template<typename Bound, typename F>
+    void Nearest(Bound lowerBound, F visit) const {
+        if (m_Nodes.empty())
+            return;
+        struct Entry {
+            int node;
+            float bound;
+        };
+        Entry stack[MAX_DEPTH + 1];
+        int size = 0;
+        stack[size++] = Entry{0, lowerBound(m_Nodes[0].bounds)};
+        float best = std::numeric_limits<float>::max();
+        while (size > 0) {
+            Entry entry = stack[--size];
+            if (entry.bound >= best)
+                continue;
+            const Node &node = m_Nodes[entry.node];
+            if (node.count > 0) {
+                for (int i = node.offset; i < node.offset + node.count; i++)
+                    best = std::min(best, visit(m_Triangles[i]));
+                continue;
+            }
+            Entry left{entry.node + 1, lowerBound(m_Nodes[entry.node + 1].bounds)};
+            Entry right{node.offset, lowerBound(m_Nodes[node.offset].bounds)};
+            // Nearer child is popped first
+            if (left.bound < right.bound)
+                std::swap(left, right);
+            stack[size++] = left;
+            stack[size++] = right;
+        }
+    }
+
+    // Calls visit(triangle) for triangles whose bounds the ray enters closer
+    // than `maxDistance`, nearer nodes first. visit returns the new maximum
+    // distance, e.g. distance of the closest hit found so far.
+    // Distances are in units of `direction`, it does not need to be normalized
+    template<typename F>
+    void Raycast(Vec3 origin, Vec3 direction, float maxDistance, F visit) const {
+        if (m_Nodes.empty())
+            return;
+        struct Entry {
+            int node;
+            float distance;
+        };
+        Vec3 inverse = InverseDirection(direction);
+        Entry stack[MAX_DEPTH + 1];
+        int size = 0;
+        stack[size++] = Entry{0, RayEntry(m_Nodes[0].bounds, origin, inverse, maxDistance)};
+        while (size > 0) {
+            Entry entry = stack[--size];
+            if (entry.distance > maxDistance)
+                continue;
+            const Node &node = m_Nodes[entry.node];
+            if (node.count > 0) {
+                for (int i = node.offset; i < node.offset + node.count; i++)
+                    maxDistance = std::min(maxDistance, visit(m_Triangles[i]));
+                continue;
+            }
+            auto enter = [&](int child) {
+                return Entry{child, RayEntry(m_Nodes[child].bounds, origin, inverse, maxDistance)};
+            };
+            Entry left = enter(entry.node + 1), right = enter(node.offset);
+            // Nearer child is popped first
+            if (left.distance < right.distance)
+                std::swap(left, right);
+            stack[size++] = left;
+            stack[size++] = right;
+        }
+    }
+
+    static float Area(const AABB &);
+
+    // Below this depth nodes are split by SAH, deeper ones in halves,
+    // so depth of the tree never exceeds 2 * BVH_SAH_DEPTH
+    static const int MAX_DEPTH = 2 * BVH_SAH_DEPTH;
+
+ private:
+    std::vector<Node> m_Nodes;
+    // Triangle numbers referenced by leaves
+    std::vector<int> m_Triangles;
+};
@@ -5,20 +5,22 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <assimp/Importer.hpp>
 
+#include "mapped_file.hpp"
+#include "model_data.hpp"
 #include "render_data.hpp"
 #include "shaders.hpp"
 #include "transform.hpp"
 #include "mesh.hpp"
+#include "geometry_primitives.hpp"
 #include "logger.hpp"
 #include "assimp_helpers.hpp"
 
-struct BoneInfo {
-    int id;
-    glm::mat4 offset;
-};
-
+// Model component. Geometry and skeleton are shared between copies,
+// so adding the same model to many objects does not copy vertex data.
+// Materials and shader belong to the copy
 class Model {
  public:
     std::vector<RenderMesh> meshes;
@@ -26,25 +28,43 @@ class Model {
 
     void setMaterial(Material material);
 
+    // Copy of the model cached by AssetManager, the file is imported once
     static Model *loadFromFile(std::string);
     static Model *fromMesh(Mesh *mesh, Material material);
+    static Model *fromScene(const aiScene *scene);
+    static Model *fromData(ModelData data);
+    // Meshes read vertices and indices from the mapping, see model_data.hpp.
+    // Returns nullptr if the file is not a valid baked model
+    static Model *fromBakedFile(std::shared_ptr<const MappedFile> file);
+    // Meshes, materials and bones of the scene in engine layout
+    static ModelData importScene(const aiScene *scene);
 
     static Model *loadFromFile(std::string, ShaderProgram*);
     static Model *fromMesh(Mesh *mesh, Material material, ShaderProgram*);
 
 
-    auto& GetBoneInfoMap() { return m_BoneInfoMap; }
-    int& GetBoneCount() { return m_BoneCounter; }
+    // Bounds of every mesh in model space. Computed on first call and kept
+    // by copies, UpdateBounds should be called after meshes change
+    const AABB &GetBounds();
+    void UpdateBounds();
+
+    auto& GetBoneInfoMap() { return m_Skeleton->boneInfoMap; }
+    int& GetBoneCount() { return m_Skeleton->boneCounter; }
 
  private:
-    void processNode(aiNode *node, const aiScene *scene);
-    RenderMesh processMesh(aiMesh *mesh, const aiScene *scene);
+    static void processNode(aiNode *node, const aiScene *scene, ModelData *data);
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene, ModelSkeleton *skeleton);
+    static Material makeMaterial(float shininess, Vec3 diffuseColor, Vec3 specularColor,
+                                 const std::string &diffuseTexture, const std::string &specularTexture);
+
+    AABB m_Bounds;
+    bool m_HasBounds = false;
 
-    std::map<std::string, BoneInfo> m_BoneInfoMap;
-    int m_BoneCounter = 0;
+    std::shared_ptr<ModelSkeleton> m_Skeleton = std::make_shared<ModelSkeleton>();
 
-    void SetVertexBoneDataToDefault(Vertex *vertex);
-    void SetVertexBoneData(Vertex *vertex, int boneID, float weight);
+    static void SetVertexBoneDataToDefault(Vertex *vertex);
+    static void SetVertexBoneData(Vertex *vertex, int boneID, float weight);
 
-    void ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh* mesh, const aiScene* scene);
+    static void ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh* mesh,
+                                             ModelSkeleton *skeleton);
 };
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "math_types.hpp"
+#include "mesh.hpp"
+
+struct BoneInfo {
+    int id;
+    glm::mat4 offset;
+};
+
+// Bones of a model file, shared by every copy of the model
+struct ModelSkeleton {
+    std::map<std::string, BoneInfo> boneInfoMap;
+    int boneCounter = 0;
+};
+
+// Mesh of a model file in engine layout, before anything is uploaded.
+// Textures are file names relative to resources/textures, empty if absent
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    float shininess = 1.0f;
+    Vec3 diffuseColor = Vec3(0.f), specularColor = Vec3(0.f);
+    std::string diffuseTexture, specularTexture;
+};
+
+struct ModelData {
+    std::vector<MeshData> meshes;
+    ModelSkeleton skeleton;
+};
+
+// Baked model file, written by the bake_models tool and mapped at load time.
+// Vertices and indices are stored in engine layout and handed to GL in place:
+//   BakedModelHeader
+//   BakedMesh[meshCount]
+//   BakedBone[boneCount]
+//   Vertex[vertexCount] and unsigned int[indexCount] of every mesh, 16 byte aligned
+//   string data, referenced by BakedString
+// Numbers are in the byte order of the machine that baked the file.
+// Files of another version or vertex layout are rejected
+#define BAKED_MODEL_MAGIC           0x4C444D42u  // "BMDL"
+#define BAKED_MODEL_VERSION         1
+
+struct BakedString {
+    uint32_t offset, length;
+};
+
+struct BakedModelHeader {
+    uint32_t magic, version;
+    uint32_t vertexSize;
+    uint32_t meshCount, boneCount;
+    int32_t boneCounter;
+    uint64_t stringsOffset, stringsSize;
+};
+
+struct BakedMesh {
+    uint64_t verticesOffset, indicesOffset;
+    uint32_t vertexCount, indexCount;
+    float shininess;
+    float diffuseColor[3], specularColor[3];
+    BakedString diffuseTexture, specularTexture;
+    uint32_t reserved;
+};
+
+struct BakedBone {
+    BakedString name;
+    int32_t id;
+    float offset[16];
+};
+
+static_assert(sizeof(BakedModelHeader) == 40, "Baked model layout changed, bump BAKED_MODEL_VERSION");
+static_assert(sizeof(BakedMesh) == 72, "Baked model layout changed, bump BAKED_MODEL_VERSION");
+static_assert(sizeof(BakedBone) == 76, "Baked model layout changed, bump BAKED_MODEL_VERSION");
+
+// Writes the model to `path` in baked format. Returns false on failure
+bool WriteBakedModel(const ModelData &model, const std::string &path);
+
+// Tables of a baked model file read in place
+struct BakedModelView {
+    const BakedModelHeader *header = nullptr;
+    const BakedMesh *meshes = nullptr;
+    const BakedBone *bones = nullptr;
+    const char *strings = nullptr;
+
+    std::string GetString(BakedString string) const {
+        return std::string(strings + string.offset, string.length);
+    }
+};
+
+// Checks the header, that every array and string lies inside the file,
+// that indices address vertices of their mesh and bone ids are below MAX_BONES.
+// Returns false if the file is not a valid baked model
+bool ReadBakedModel(const unsigned char *data, size_t size, BakedModelView *view);
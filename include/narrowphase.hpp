@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "broadphase.hpp"
+#include "collider.hpp"
+#include "job_system.hpp"
+#include "manifold.hpp"
+#include "packed_array.hpp"
+
+// World-space spheres stored coordinate by coordinate
+struct SphereArray {
+    using Shape = Sphere;
+
+    std::vector<float> centerX, centerY, centerZ, radius;
+
+    void Resize(int size);
+    void Set(int index, const Sphere &);
+};
+
+// World-space boxes stored coordinate by coordinate
+struct AABBArray {
+    using Shape = AABB;
+
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void Resize(int size);
+    void Set(int index, const AABB &);
+};
+
+// Manifolds stored field by field, filled by CollideBatch
+struct ManifoldArray {
+    std::vector<uint8_t> collide;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<float> pointX, pointY, pointZ;
+    std::vector<float> depth;
+
+    void Resize(int size);
+    // Manifold of a pair that does not collide is a default one
+    CollisionManifold Get(int index) const;
+};
+
+// Tests a[i] against b[i] for i in [begin, end). Manifolds are the same as
+// CollidePrimitive gives for these shapes. Loops have no branches, so optimized
+// builds compile them to vector instructions
+void CollideBatch(const SphereArray &a, const SphereArray &b, int begin, int end, ManifoldArray *out);
+void CollideBatch(const SphereArray &a, const AABBArray &b, int begin, int end, ManifoldArray *out);
+void CollideBatch(const AABBArray &a, const AABBArray &b, int begin, int end, ManifoldArray *out);
+
+// Tests pairs reported by broadphase.
+// World-space shapes of spheres and AABBs are computed once per collider.
+// Pairs of them are grouped by combination of shapes, gathered into arrays
+// and tested by CollideBatch in parallel chunks. Other pairs go through
+// Collider::Collide one by one.
+class Narrowphase {
+ public:
+    // Sets (*out)[i] to what Collider::Collide gives for pairs[i].a and pairs[i].b.
+    // `transforms` are global transforms of colliders indexed by slot of the handle
+    void Collide(const std::vector<BroadphasePair> &pairs, PackedArray<Collider> *colliders,
+                 const std::vector<Transform> &transforms, JobSystem *jobs,
+                 std::vector<CollisionManifold> *out);
+
+ private:
+    enum Kind : uint8_t {
+        SPHERE,
+        BOX,
+        OTHER,
+    };
+
+    // Pairs whose first shape goes to First and second one to Second arrays
+    template<typename First, typename Second>
+    struct Batch {
+        First first;
+        Second second;
+        ManifoldArray manifolds;
+        // Position of the pair in the list given to Collide
+        std::vector<int> pairs;
+        // Shapes of the pair go in reverse order, normal is flipped back when stored
+        std::vector<uint8_t> swapped;
+
+        void Clear();
+        void Add(int pair, bool swap);
+    };
+
+    template<typename First, typename Second>
+    void Run(Batch<First, Second> *, const std::vector<BroadphasePair> &pairs, JobSystem *jobs,
+             std::vector<CollisionManifold> *out);
+
+    const Sphere &GetShape(ObjectHandle, const SphereArray *) const;
+    const AABB &GetShape(ObjectHandle, const AABBArray *) const;
+
+    // Indexed by slot of the handle. Only the shape of the collider's kind is set
+    std::vector<uint8_t> m_Kinds;
+    std::vector<Sphere> m_Spheres;
+    std::vector<AABB> m_AABBs;
+
+    Batch<SphereArray, SphereArray> m_SphereSphere;
+    Batch<SphereArray, AABBArray> m_SphereAABB;
+    Batch<AABBArray, AABBArray> m_AABBAABB;
+    // Pairs that are tested one by one
+    std::vector<int> m_Other;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 
 #include "transform.hpp"
 #include "collider.hpp"
@@ -35,69 +36,79 @@ class Object {
     SpotLight *GetSpotLight();
     Behaviour *GetBehaviour();
 
+    template<typename T>
+    T *Get() {
+        return m_Engine->Get<T>(m_Handle);
+    }
+
+    template<typename T>
+    void RemoveComponent() {
+        m_Engine->Remove<T>(m_Handle);
+    }
+
     template<typename ...Ts>
-    Transform &AddTransform(Ts... ts) {
-        return m_Engine->AddTransform(m_Handle, Transform{ts...});
+    Transform &AddTransform(Ts &&...ts) {
+        return m_Engine->Add<Transform>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    Model &AddModel(Ts... ts) {
-        return m_Engine->AddModel(m_Handle, Model{ts...});
+    Model &AddModel(Ts &&...ts) {
+        return m_Engine->Add<Model>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    Collider &AddCollider(Ts... ts) {
-        return m_Engine->AddCollider(m_Handle, Collider{ts...});
+    Collider &AddCollider(Ts &&...ts) {
+        return m_Engine->Add<Collider>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    RigidBody &AddRigidBody(Ts... ts) {
-        return m_Engine->AddRigidBody(m_Handle, RigidBody{ts...});
+    RigidBody &AddRigidBody(Ts &&...ts) {
+        return m_Engine->Add<RigidBody>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    Text &AddText(Ts... ts) {
-        return m_Engine->AddText(m_Handle, Text{ts...});
+    Text &AddText(Ts &&...ts) {
+        return m_Engine->Add<Text>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    SkeletalAnimationsManager &AddSkeletalAnimationsManager(Ts... ts) {
-        return m_Engine->AddSkeletalAnimationsManager(m_Handle, SkeletalAnimationsManager{ts...});
+    SkeletalAnimationsManager &AddSkeletalAnimationsManager(Ts &&...ts) {
+        return m_Engine->Add<SkeletalAnimationsManager>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    Image &AddImage(Ts... ts) {
-        return m_Engine->AddImage(m_Handle, Image{ts...});
+    Image &AddImage(Ts &&...ts) {
+        return m_Engine->Add<Image>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    Sound &AddSound(Ts... ts) {
-        return m_Engine->AddSound(m_Handle, Sound{ts...});
+    Sound &AddSound(Ts &&...ts) {
+        return m_Engine->Add<Sound>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    Animation &AddAnimation(Ts... ts) {
-        return m_Engine->AddAnimation(m_Handle, Animation{ts...});
+    Animation &AddAnimation(Ts &&...ts) {
+        return m_Engine->Add<Animation>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    SpotLight &AddSpotLight(Ts... ts) {
-        return m_Engine->AddSpotLight(m_Handle, SpotLight{ts...});
+    SpotLight &AddSpotLight(Ts &&...ts) {
+        return m_Engine->Add<SpotLight>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    PointLight &AddPointLight(Ts... ts) {
-        return m_Engine->AddPointLight(m_Handle, PointLight{ts...});
+    PointLight &AddPointLight(Ts &&...ts) {
+        return m_Engine->Add<PointLight>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename ...Ts>
-    DirLight &AddDirLight(Ts... ts) {
-        return m_Engine->AddDirLight(m_Handle, DirLight{ts...});
+    DirLight &AddDirLight(Ts &&...ts) {
+        return m_Engine->Add<DirLight>(m_Handle, std::forward<Ts>(ts)...);
     }
 
     template<typename T, typename ...Ts>
-    T &AddBehaviour(Ts... ts) {
-        auto &res = m_Engine->AddBehaviour(m_Handle, new T{ts...});
+    T &AddBehaviour(Ts &&...ts) {
+        auto &res = m_Engine->AddBehaviour(m_Handle, new T{std::forward<Ts>(ts)...});
         res.self = *this;
         return res;
     }
@@ -1,124 +1,178 @@
 #pragma once
 #include <vector>
-#include <array>
+#include <cassert>
+#include <type_traits>
+#include <utility>
 #include "logger.hpp"
-
+#include "handle.hpp"
+
+// Sparse set keyed by object handles.
+// Data is stored densely in `entries`, a sparse table maps slot of the handle
+// to position in `entries`. Dense storage grows with the number of live
+// entries, sparse table with the highest slot ever stored (4 bytes per slot).
+// Entry is found only if its generation matches, so stale handles miss.
+// Adding data may reallocate `entries`: pointers to data are valid until
+// the next SetData.
 // TODO(theblek): Overload [] operator to get data for even slicker syntax
-template<typename T, int MAX_SIZE>
+template<typename T>
 class PackedArray {
  public:
-    using Index = int;
-
-    std::array<T, MAX_SIZE> entries;
+    using Index = ObjectHandle;
 
-    PackedArray() : m_EntryCount(0) {
-        for (unsigned int i = 0; i < MAX_SIZE; i++) {
-            m_EntryToIndex[i] = i;
-            m_IndexToEntry[i] = i;
-        }
-    }
+    std::vector<T> entries;
 
-    bool HasData(Index entry) {
-        if (entry < 0 || entry >= MAX_SIZE) {
+    bool HasData(Index entry) const {
+        if (entry < 0) {
             Logger::Error("Invalid entry access at pos: %d", entry);
             return false;
         }
-        return m_EntryToIndex[entry] < m_EntryCount;
+        return FindIndex(entry) != -1;
     }
 
     void RemoveData(Index entry) {
-        if (!HasData(entry)) {
+        int removedIndex = entry < 0 ? -1 : FindIndex(entry);
+        if (removedIndex == -1) {
             Logger::Error("Entry %d does not have valid data to remove", entry);
             return;
         }
 
-        // If not the last one
-        if (m_EntryToIndex[entry] < m_EntryCount - 1) {
-            // Move last one to deleted position
-            Index removedIndex = m_EntryToIndex[entry];
-            Swap(entry, m_EntryCount - 1);
-            entries[removedIndex] = entries[m_EntryCount - 1];
+        // If not the last one, move last one to deleted position
+        int lastIndex = GetSize() - 1;
+        if (removedIndex < lastIndex) {
+            entries[removedIndex] = std::move(entries[lastIndex]);
+            m_IndexToEntry[removedIndex] = m_IndexToEntry[lastIndex];
+            m_EntryToIndex[GetHandleIndex(m_IndexToEntry[removedIndex])] = removedIndex;
         }
-
-        m_EntryCount--;
+        m_EntryToIndex[GetHandleIndex(entry)] = -1;
+        entries.pop_back();
+        m_IndexToEntry.pop_back();
     }
 
     T &GetData(Index entry) {
-        if (!HasData(entry))
+        int index = entry < 0 ? -1 : FindIndex(entry);
+        if (index == -1)
             Logger::Error("Entry %d does not have valid data", entry);
+        assert(index != -1 && "Check HasData before GetData");
 
-        return entries[m_EntryToIndex[entry]];
+        return entries[index];
     }
 
     void SetData(Index entry, const T &data) {
-        if (entry < 0 || entry >= MAX_SIZE) {
+        Emplace(entry, data);
+    }
+
+    void SetData(Index entry, T &&data) {
+        Emplace(entry, std::move(data));
+    }
+
+    // Constructs data of the entry from `args`, T(args...) if there is such
+    // constructor and T{args...} otherwise. New entries are built in place,
+    // existing ones are move-assigned. Returns nullptr on invalid entry
+    template<typename ...Args>
+    T *Emplace(Index entry, Args &&...args) {
+        if (entry < 0) {
             Logger::Error("Invalid entry access at pos: %d", entry);
-            return;
+            return nullptr;
         }
-        // If entry is new
-        if (m_EntryToIndex[entry] >= m_EntryCount) {
-            Swap(entry, m_EntryCount);
-            m_EntryCount++;
+        int index = FindIndex(entry);
+        if (index != -1) {
+            entries[index] = Construct(std::forward<Args>(args)...);
+            return &entries[index];
         }
 
-        entries[m_EntryToIndex[entry]] = data;
+        int slot = GetHandleIndex(entry);
+        if (slot >= m_EntryToIndex.size())
+            m_EntryToIndex.resize(slot + 1, -1);
+        if (m_EntryToIndex[slot] != -1) {
+            Logger::Error("Entry %d: slot is taken by entry %d",
+                          entry, m_IndexToEntry[m_EntryToIndex[slot]]);
+            return nullptr;
+        }
+
+        m_EntryToIndex[slot] = GetSize();
+        m_IndexToEntry.push_back(entry);
+        if constexpr (std::is_constructible_v<T, Args...>)
+            entries.emplace_back(std::forward<Args>(args)...);
+        else
+            entries.push_back(T{std::forward<Args>(args)...});
+        return &entries.back();
     }
 
     // BEWARE RETURED INDEX IS INTERNAL
     // AND THEREFORE SHOULD ONLY BE USED TO ITERATE OVER INTERNAL ARRAY
     int GetSize() const {
-        return m_EntryCount;
+        return static_cast<int>(entries.size());
     }
 
     // This should only be used in conjection with iteration over
     // the underlying array `entries`
-    Index GetFromInternal(int index) {
+    Index GetFromInternal(int index) const {
         return m_IndexToEntry[index];
     }
 
-    Index GetEmptyEntry() const {
-        return m_IndexToEntry[m_EntryCount];
+    // Position of entry in the internal array. Entry must have data
+    int GetInternalIndex(Index entry) const {
+        return m_EntryToIndex[GetHandleIndex(entry)];
     }
 
-    Index AddData(const T &data) {
-        if (m_EntryCount == MAX_SIZE) {
-            Logger::Error("Adding entry into full array with size: %d", m_EntryCount);
-            return -1;
-        }
-        Index place = GetEmptyEntry();
-        SetData(place, data);
-        return place;
+    // Entries in internal order, GetInternalEntries()[i] == GetFromInternal(i)
+    const Index *GetInternalEntries() const {
+        return m_IndexToEntry.data();
+    }
+
+    // Returns nullptr if entry has no data. Entry must not be negative
+    T *Find(Index entry) {
+        int index = FindIndex(entry);
+        return index != -1 ? &entries[index] : nullptr;
+    }
+
+    // Moves data of the entry to internal position `index`.
+    // Entry stored there takes the old place. Both must have data
+    void MoveToInternal(Index entry, int index) {
+        int from = GetInternalIndex(entry);
+        if (from == index)
+            return;
+        std::swap(entries[from], entries[index]);
+        std::swap(m_IndexToEntry[from], m_IndexToEntry[index]);
+        m_EntryToIndex[GetHandleIndex(m_IndexToEntry[from])] = from;
+        m_EntryToIndex[GetHandleIndex(m_IndexToEntry[index])] = index;
     }
 
     T *begin() {
-        return &entries[0];
+        return entries.data();
     }
 
     T *end() {
-        return &entries[m_EntryCount];
+        return entries.data() + entries.size();
     }
 
     const T *begin() const {
-        return &entries[0];
+        return entries.data();
     }
 
     const T *end() const {
-        return &entries[m_EntryCount];
+        return entries.data() + entries.size();
     }
 
-
  private:
-    // BEWARE: aEntry is a public index, while bIndex in a private one.
-    void Swap(Index aEntry, Index bIndex) {
-        Index bEntry = m_IndexToEntry[bIndex];
-        Index aIndex = m_EntryToIndex[aEntry];
-        m_EntryToIndex[aEntry] = bIndex;
-        m_EntryToIndex[bEntry] = aIndex;
-        m_IndexToEntry[aIndex] = bEntry;
-        m_IndexToEntry[bIndex] = aEntry;
-    }
-
-    Index m_EntryCount;
-    std::array<Index, MAX_SIZE> m_EntryToIndex;
-    std::array<Index, MAX_SIZE> m_IndexToEntry;
+    template<typename ...Args>
+    static T Construct(Args &&...args) {
+        if constexpr (std::is_constructible_v<T, Args...>)
+            return T(std::forward<Args>(args)...);
+        else
+            return T{std::forward<Args>(args)...};
+    }
+
+    int FindIndex(Index entry) const {
+        int slot = GetHandleIndex(entry);
+        if (slot >= m_EntryToIndex.size())
+            return -1;
+        int index = m_EntryToIndex[slot];
+        return index != -1 && m_IndexToEntry[index] == entry ? index : -1;
+    }
+
+    // Slot of handle -> position in entries, -1 if there is no data
+    std::vector<int> m_EntryToIndex;
+    // Position in entries -> full handle
+    std::vector<Index> m_IndexToEntry;
 };
@@ -1,20 +1,62 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "array_view.hpp"
 #include "material.hpp"
 #include "mesh.hpp"
 
-class RenderMesh : public Mesh {
+// Vertices and indices of a mesh together with their GPU buffers.
+// Immutable once created and shared by every RenderMesh made from it,
+// buffers are freed when the last reference is gone.
+class MeshAsset {
+ public:
+    // `skinned` tells that the mesh belongs to a model with a skeleton,
+    // see VertexLayout::For
+    MeshAsset(std::vector<Vertex> points, std::vector<unsigned int> indices, bool skinned = false);
+    // Arrays are read in place and must stay inside `storage`,
+    // which is kept alive by the asset. Used for mapped baked models
+    MeshAsset(std::shared_ptr<const void> storage, ArrayView<Vertex> points,
+              ArrayView<unsigned int> indices, bool skinned = false);
+    ~MeshAsset();
+
+    MeshAsset(const MeshAsset &) = delete;
+    MeshAsset &operator=(const MeshAsset &) = delete;
+
+    ArrayView<Vertex> GetPoints() const;
+    ArrayView<unsigned int> GetIndices() const;
+    unsigned int GetVAO() const;
+
+ private:
+    void Upload(bool skinned);
+
+    std::shared_ptr<const void> m_Storage;
+    ArrayView<Vertex> m_Points;
+    ArrayView<unsigned int> m_Indices;
+    unsigned int m_VAO = 0, m_VBO = 0, m_EBO = 0;
+};
+
+// Mesh of a model: shared geometry and material of this instance.
+// Copies are cheap and only the material is copied
+class RenderMesh {
  public:
     Material material;
-    unsigned int VAO, VBO, EBO;
 
     void setMaterial(Material material);
 
-    RenderMesh(std::vector<Vertex> points, std::vector<unsigned int> indices, Material material);
+    RenderMesh(std::vector<Vertex> points, std::vector<unsigned int> indices, Material material,
+               bool skinned = false);
 
     RenderMesh(Mesh *mesh, Material material);
-};
 
-void bindRenderData(RenderMesh*);
+    RenderMesh(std::shared_ptr<const MeshAsset> asset, Material material);
+
+    const std::shared_ptr<const MeshAsset> &getAsset() const;
+    ArrayView<Vertex> getVecPoints() const;
+    int getLenIndices() const;
+    unsigned int getVAO() const;
+
+ private:
+    std::shared_ptr<const MeshAsset> m_Asset;
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "math_types.hpp"
+#include "render_data.hpp"
+#include "shaders.hpp"
+
+// One mesh of an object to be drawn on the current frame
+struct DrawItem {
+    // Items are drawn in order of their keys, see RenderQueue::Push
+    uint64_t key;
+    ShaderProgram *shader;
+    RenderMesh *mesh;
+    // World matrix and bone palette of the object, bones may be nullptr.
+    // Both must stay valid until Submit
+    const Mat4 *world;
+    const std::vector<Mat4> *bones;
+};
+
+// Counters of the last submitted frame
+struct RenderStats {
+    // Objects skipped by frustum culling
+    int culledObjects = 0;
+    int items = 0;
+    int drawCalls = 0;
+    int instancedDrawCalls = 0;
+    int programChanges = 0;
+    int textureChanges = 0;
+    int vertexArrayChanges = 0;
+    int materialChanges = 0;
+};
+
+// Collects draw items of a frame, sorts them by GL state and submits them
+// skipping state that is already set.
+// Key is program (16 bits), first texture (16 bits), vertex array (16 bits)
+// and object order (16 bits), so items sharing state end up next to each
+// other and meshes of one object stay together within the same state.
+// Instanced programs use material hash instead of object order.
+// GL names are truncated to fit, which only makes sorting less effective:
+// redundant state is detected by comparing the real values.
+//
+// Items of an instanced program (see ShaderProgram::IsInstanced) that share
+// vertex array and material are drawn with one instanced call. Their world
+// matrices are uploaded to the instance buffer once per frame.
+class RenderQueue {
+ public:
+    RenderQueue() = default;
+    ~RenderQueue();
+
+    RenderQueue(const RenderQueue &) = delete;
+    RenderQueue &operator=(const RenderQueue &) = delete;
+
+    // Starts a new frame, resets stats
+    void Clear();
+
+    // Records objects that were culled instead of being pushed
+    void CountCulled(int objects);
+
+    // Adds every mesh of the object. Objects are numbered in the order they are pushed
+    void Push(ShaderProgram *, std::vector<RenderMesh> *meshes, const Mat4 *world,
+              const std::vector<Mat4> *bones);
+
+    // Sorts and draws the items. Uniforms shared by every object are set
+    // once per program change
+    void Submit(const Mat4 &view, const Mat4 &projection, Vec3 viewPos);
+
+    const RenderStats &GetStats() const;
+
+ private:
+    // Items [begin, end) drawn with one call
+    struct Batch {
+        int begin, end;
+        // First matrix in the instance buffer, -1 if not instanced
+        int instanceOffset;
+    };
+
+    static uint64_t GetKey(ShaderProgram *, RenderMesh *, int object);
+    // Material fields other than textures folded to 16 bits
+    static uint64_t MaterialHash(const Material &);
+    // Whether both materials set the same uniforms and textures
+    static bool SameMaterial(const Material &, const Material &);
+    static bool CanInstance(const DrawItem &first, const DrawItem &item);
+    // Splits sorted items into batches and fills the instance buffer
+    void BuildBatches();
+    void BindTextures(Texture *);
+    void SetMaterial(ShaderProgram *, Material *);
+
+    std::vector<DrawItem> m_Items;
+    std::vector<Batch> m_Batches;
+    std::vector<Mat4> m_InstanceMatrices;
+    unsigned int m_InstanceBuffer = 0;
+    int m_Objects = 0;
+    // Texture bound to every unit during Submit
+    unsigned int m_BoundTextures[MAX_COUNT_TEXTURE];
+    // Material whose uniforms are set in each program during Submit.
+    // Programs keep uniforms while others are used, so this is per program
+    std::vector<std::pair<unsigned int, const Material *>> m_ProgramMaterials;
+    RenderStats m_Stats;
+};
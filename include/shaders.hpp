@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <functional>
+#include <map>
 #include <string>
 
 #include "math_types.hpp"
@@ -19,10 +21,15 @@ class Shader {
      explicit Shader(ShaderType shaderType, std::string path);
 };
 
+// Uniform locations are cached by name, so every name is resolved once per
+// program whatever buffer it comes from
 class ShaderProgram {
  private:
      unsigned int m_Program = 0;
-     unsigned int GetLoc(const char* name);
+     bool m_Instanced = false;
+     // std::less<> finds C strings without building a std::string
+     std::map<std::string, int, std::less<>> m_Locations;
+     int GetLoc(const char* name);
 
  public:
      int AttachShader(Shader shader);
@@ -34,6 +41,10 @@ class ShaderProgram {
      ShaderProgram();
      ShaderProgram(Shader vShader, Shader fShader);
      int Use();
+     // GL name of the program
+     unsigned int GetId() const;
+     // Whether world matrices come from INSTANCE_MATRIX_ATTRIBUTE instead of "model" uniform
+     bool IsInstanced() const;
      int UniformLocation(const char* mode);
 
      void SetFloat(const char* name, const float value);
@@ -46,4 +57,6 @@ class ShaderProgram {
      void SetVec4i(const char* name, const Vec4Int vec);
      void SetMat3(const char* name, const Mat3 mat);
      void SetMat4(const char* name, const Mat4 mat);
+     // Sets `count` elements of a matrix array uniform starting from `name`
+     void SetMat4Array(const char* name, const Mat4* mats, int count);
 };
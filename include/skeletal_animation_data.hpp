@@ -25,8 +25,10 @@ class SkeletalAnimationData {
     SkeletalAnimationData(const std::string& animationPath, const aiScene* scene,
                                                             unsigned int animationIndex, Model* model);
 
-    Bone *FindBone(const std::string& name);
-    BoneInfo *FindBoneInfo(const std::string& name);
+    // Nodes are numbered in depth-first order of the hierarchy starting
+    // from the root. Return nullptr if the node is not animated
+    const Bone *GetNodeBone(int nodeIndex) const;
+    const BoneInfo *GetNodeBoneInfo(int nodeIndex) const;
 
     float GetTicksPerSecond();
     float GetDuration();
@@ -45,9 +47,8 @@ class SkeletalAnimationData {
     float m_TicksPerSecond;
     std::string m_Name;
     std::map<std::string, BoneInfo> m_BoneInfoMap;
+    // Both are indexed by node in depth-first order
     std::vector<std::pair<std::string, BoneInfo*> > m_BonesInfos;
     std::vector<Bone> m_Bones;
-    int m_LastBoneIndex = 0;
-    int m_LastBoneInfoIndex = 0;
     AssimpNodeData m_RootNode;
 };
@@ -35,7 +35,8 @@ class SkeletalAnimationsManager {
     const std::vector<glm::mat4> &GetFinalBoneMatrices();
 
  private:
-    void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform);
+    // nodeIndex is depth-first number of the node, advanced past its subtree
+    void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform, int *nodeIndex);
 
     std::vector<glm::mat4> m_FinalBoneMatrices;
     std::vector<SkeletalAnimationData*> m_Animations;
@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "component_registry.hpp"
+#include "job_system.hpp"
+
+// Components accessed by a system, see SystemScheduler::Add
+template<typename ...Ts>
+struct Reads {};
+
+template<typename ...Ts>
+struct Writes {};
+
+// Stands for every component in Reads and Writes
+struct AllComponents {};
+
+template<typename List>
+class SystemScheduler;
+
+// Runs systems of a frame on a JobSystem.
+// Every system declares which components it reads and writes. Two systems
+// conflict when one of them writes a component the other one accesses.
+// Conflicting systems run in the order they were added, the rest run
+// concurrently as soon as systems they depend on are finished.
+// Engine state derived from components, such as cached world transforms,
+// counts as the component it is derived from.
+//
+// Without workers systems run one by one in the order they were added.
+template<typename ...Components>
+class SystemScheduler<TypeList<Components...>> {
+ public:
+    using Signature = std::bitset<sizeof...(Components)>;
+    using Function = std::function<void(float)>;
+
+    // Read and Write are Reads<...> and Writes<...>
+    template<typename Read, typename Write>
+    void Add(Function function) {
+        AddSystem(std::move(function), MaskOf(Read{}), MaskOf(Write{}), false);
+    }
+
+    // Same as Add, but the system is always run by the thread calling Run
+    template<typename Read, typename Write>
+    void AddOnMainThread(Function function) {
+        AddSystem(std::move(function), MaskOf(Read{}), MaskOf(Write{}), true);
+    }
+
+    // Runs every system once and waits for them
+    void Run(JobSystem *jobs, float deltaTime) {
+        if (jobs->GetWorkerCount() == 0) {
+            for (auto &system : m_Systems)
+                system->function(deltaTime);
+            return;
+        }
+
+        m_Jobs = jobs;
+        m_DeltaTime = deltaTime;
+        m_Remaining.store(static_cast<int>(m_Systems.size()), std::memory_order_relaxed);
+        for (auto &system : m_Systems)
+            system->waiting.store(system->dependencies, std::memory_order_relaxed);
+        for (int i = 0; i < m_Systems.size(); i++) {
+            if (m_Systems[i]->dependencies == 0)
+                Start(i);
+        }
+
+        while (m_Remaining.load(std::memory_order_acquire) > 0) {
+            int index = PopMainThread();
+            if (index != -1)
+                Execute(index);
+            else if (!jobs->RunPending())
+                std::this_thread::yield();
+        }
+    }
+
+ private:
+    struct System {
+        Function function;
+        Signature reads, writes;
+        bool mainThread;
+        // Systems added later that conflict with this one
+        std::vector<int> dependents;
+        int dependencies = 0;
+        // Dependencies not finished on the current frame
+        std::atomic<int> waiting{0};
+    };
+
+    template<typename ...Ts>
+    static Signature MaskOf(Reads<Ts...>) {
+        return MaskOfTypes<Ts...>();
+    }
+
+    template<typename ...Ts>
+    static Signature MaskOf(Writes<Ts...>) {
+        return MaskOfTypes<Ts...>();
+    }
+
+    template<typename ...Ts>
+    static Signature MaskOfTypes() {
+        Signature result;
+        // Unused when the pack is empty, as in Reads<>
+        [[maybe_unused]] auto add = [&](auto *tag) {
+            using T = std::remove_pointer_t<decltype(tag)>;
+            if constexpr (std::is_same_v<T, AllComponents>)
+                result.set();
+            else
+                result.set(TypeIndex<T, Components...>::value);
+        };
+        (add(static_cast<Ts *>(nullptr)), ...);
+        return result;
+    }
+
+    static bool Conflict(const System &a, const System &b) {
+        return (a.writes & (b.reads | b.writes)).any() || (b.writes & a.reads).any();
+    }
+
+    void AddSystem(Function function, Signature reads, Signature writes, bool mainThread) {
+        auto system = std::make_unique<System>();
+        system->function = std::move(function);
+        system->reads = reads;
+        system->writes = writes;
+        system->mainThread = mainThread;
+        int index = static_cast<int>(m_Systems.size());
+        for (auto &other : m_Systems) {
+            if (!Conflict(*other, *system))
+                continue;
+            other->dependents.push_back(index);
+            system->dependencies++;
+        }
+        m_Systems.push_back(std::move(system));
+        m_MainThreadReady.reserve(m_Systems.size());
+    }
+
+    void Start(int index) {
+        if (!m_Systems[index]->mainThread) {
+            m_Jobs->Run(nullptr, &SystemScheduler::RunJob, this, index);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+        m_MainThreadReady.push_back(index);
+    }
+
+    static void RunJob(void *data, int index, int) {
+        static_cast<SystemScheduler *>(data)->Execute(index);
+    }
+
+    void Execute(int index) {
+        System &system = *m_Systems[index];
+        system.function(m_DeltaTime);
+        for (int dependent : system.dependents) {
+            if (m_Systems[dependent]->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                Start(dependent);
+        }
+        m_Remaining.fetch_sub(1, std::memory_order_release);
+    }
+
+    int PopMainThread() {
+        std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+        if (m_MainThreadReady.empty())
+            return -1;
+        int index = m_MainThreadReady.back();
+        m_MainThreadReady.pop_back();
+        return index;
+    }
+
+    std::vector<std::unique_ptr<System>> m_Systems;
+
+    // State of the frame being run
+    JobSystem *m_Jobs = nullptr;
+    float m_DeltaTime = 0.f;
+    std::atomic<int> m_Remaining{0};
+    std::mutex m_MainThreadMutex;
+    std::vector<int> m_MainThreadReady;
+};
@@ -1,12 +1,41 @@
 #pragma once 
 
+#include <memory>
 #include <vector>
 #include <string>
 #include "engine_config.hpp"
 
+// Pixels of an image file. Decoding needs no GL context, so it may run on any thread
+struct DecodedImage {
+    std::shared_ptr<unsigned char> pixels;
+    int width = 0, height = 0, components = 0;
+
+    // Pixels are empty if the file can't be decoded. Path must be resolved
+    static DecodedImage Decode(const std::string &path);
+};
+
+// GL texture loaded from a file, deleted with the last reference.
+// Created through AssetManager, so every file is loaded once
+struct TextureAsset {
+    unsigned int id = 0;
+    int width = 0, height = 0;
+
+    TextureAsset() = default;
+    ~TextureAsset();
+    TextureAsset(const TextureAsset &) = delete;
+    TextureAsset &operator=(const TextureAsset &) = delete;
+
+    // Mipmapped and repeated, for materials. Path must be resolved
+    static std::shared_ptr<const TextureAsset> FromFile(const std::string &path);
+    // Same as FromFile for an image decoded beforehand. Returns nullptr if it has no pixels
+    static std::shared_ptr<const TextureAsset> FromDecoded(const DecodedImage &image);
+    // RGBA, clamped and without mipmaps, for images on screen. Path must be resolved
+    static std::shared_ptr<const TextureAsset> FromImageFile(const std::string &path);
+};
+
 class Texture {
  private:
-    unsigned int m_TextureId[MAX_COUNT_TEXTURE];
+    std::shared_ptr<const TextureAsset> m_Textures[MAX_COUNT_TEXTURE];
     int m_Count = 0;
 
  public:
@@ -20,9 +49,9 @@ class Texture {
 
     void loadImage(std::string path);
 
-    int countComponents();
+    int countComponents() const;
 
-    unsigned int textureId(int idx);
+    unsigned int textureId(int idx) const;
 
     void bind();
 };
@@ -8,9 +8,14 @@ class Transform {
     Vec3 m_Translation;
     Vec3 m_Scale;
     Mat4 m_Rotation;
+    // Set on every change. Engine clears it when world transforms are updated
+    bool m_Dirty = true;
 
  public:
     Transform() = default;
+    // Copies are always dirty: assigning a transform changes it
+    Transform(const Transform &);
+    Transform &operator=(const Transform &);
     explicit Transform(Vec3 translation, Vec3 scale, float radiansDegree, Vec3 rotationAxis);
     explicit Transform(Vec3 translation, Vec3 scale, Mat4 rotationMatrix);
 
@@ -34,11 +39,18 @@ class Transform {
     void RotateGlobal(float radiansDegree, Vec3 rotationAxis);
     void RotateGlobal(float radiansDegreeX, float radiansDegreeY, float radiansDegreeZ);
 
+    bool IsDirty();
+    void ClearDirty();
+
     // Getters
-    Vec3 GetTranslation();
-    Vec3 GetScale();
-    Mat4 GetRotation();
-    Mat4 GetTransformMatrix();
+    Vec3 GetTranslation() const;
+    Vec3 GetScale() const;
+    Mat4 GetRotation() const;
+    Mat4 GetTransformMatrix() const;
 };
 
+// Matrix of the transform between `from` (alpha = 0) and `to` (alpha = 1).
+// Translation and scale are interpolated linearly, rotation spherically
+Mat4 InterpolateTransformMatrix(Transform &from, Transform &to, float alpha);
+
 #endif  // SRC_TRANSFORM_TRANSFORM_HPP_
@@ -7,6 +7,11 @@
 
 // Engine
 #define FPS_LIMIT 300
+// Physics runs in fixed steps of 1 / PHYSICS_TICK_RATE seconds
+#define PHYSICS_TICK_RATE 120
+// Steps per frame are capped, the rest of the time is dropped when
+// simulation can not keep up
+#define MAX_PHYSICS_STEPS 8
 
 // Movement
 #define SENSIVITY 0.001f
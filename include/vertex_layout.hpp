@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include "array_view.hpp"
+#include "mesh.hpp"
+
+// Field of Vertex an attribute is read from
+enum class VertexElement {
+    Position,
+    Normal,
+    TexCoords,
+    BoneIds,
+    Weights
+};
+
+// Storage of an attribute in a vertex buffer
+enum class VertexFormat {
+    Float2,
+    Float3,
+    Float4,
+    // Integer attribute
+    Int4,
+    // Signed normalized 10:10:10:2, w is unused
+    Snorm10x3,
+    Half2,
+    // Integer attribute
+    UByte4,
+    Unorm8x4
+};
+
+struct VertexAttribute {
+    int location;
+    VertexElement element;
+    VertexFormat format;
+    int offset;
+};
+
+// How vertices are stored in a vertex buffer. Locations match the vertex
+// shaders: 0 position, 1 normal, 2 texture coordinates, 3 bone ids, 4 weights.
+// Bone ids are 8 bit in compact layouts, so MAX_BONES must stay below 256
+struct VertexLayout {
+    int stride;
+    std::vector<VertexAttribute> attributes;
+
+    // Vertex as it is, 64 bytes
+    static const VertexLayout &Full();
+    // Float position, 10:10:10 normal and half float UVs, 20 bytes
+    static const VertexLayout &Static();
+    // Static with 8 bit bone ids and weights, 28 bytes.
+    // Missing influences have id 0 and weight 0
+    static const VertexLayout &Skinned();
+    // Full if COMPACT_VERTICES is off, otherwise Skinned for meshes of a model
+    // with a skeleton and Static for the rest. Every mesh of a skinned model
+    // gets bone attributes, even one with no influences, since the skeletal
+    // shader reads them for all meshes of the model
+    static const VertexLayout &For(bool skinned);
+
+    // Writes vertices in this layout, `out` must hold stride * size bytes
+    void Pack(ArrayView<Vertex> vertices, unsigned char *out) const;
+    // Points attributes of the bound vertex array to the bound vertex buffer
+    void Bind() const;
+};
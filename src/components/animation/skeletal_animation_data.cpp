@@ -1,18 +1,15 @@
 #include "skeletal_animation_data.hpp"
+#include "asset_manager.hpp"
 
 
 SkeletalAnimationData::SkeletalAnimationData(const std::string& animationPath,
                                             unsigned int animationIndex, Model* model) {
 
-    Assimp::Importer importer;
-    std::string finalPath = GetResourcePath(Resource::MODEL, animationPath);
-    const aiScene* scene = importer.ReadFile(finalPath, aiProcess_Triangulate | aiProcess_FlipUVs);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        Logger::Error("ERROR::ASSIMP::%s", importer.GetErrorString());
+    auto scene = AssetManager::LoadScene(animationPath);
+    if (!scene)
         return;
-    }
 
-    ConstructorHelper(animationPath, scene, animationIndex, model);
+    ConstructorHelper(animationPath, scene.get(), animationIndex, model);
 }
 
 SkeletalAnimationData::SkeletalAnimationData(const std::string& animationPath, const aiScene* scene,
@@ -21,25 +18,13 @@ SkeletalAnimationData::SkeletalAnimationData(const std::string& animationPath, c
     ConstructorHelper(animationPath, scene, animationIndex, model);
 }
 
-Bone* SkeletalAnimationData::FindBone(const std::string& name) {
-    if (m_LastBoneIndex >= m_Bones.size()) {
-        m_LastBoneIndex = 0;
-    }
-    if (m_Bones[m_LastBoneIndex].GetBoneID() == -1) {
-        m_LastBoneIndex++;
-        return nullptr;
-    }
-
-    assert(m_Bones[m_LastBoneIndex].GetBoneName() == name);
-    return &m_Bones[m_LastBoneIndex++];
+const Bone *SkeletalAnimationData::GetNodeBone(int nodeIndex) const {
+    const Bone &bone = m_Bones[nodeIndex];
+    return bone.GetBoneID() != -1 ? &bone : nullptr;
 }
 
-BoneInfo* SkeletalAnimationData::FindBoneInfo(const std::string& name) {
-    if (m_LastBoneInfoIndex >= m_BonesInfos.size()) {
-        m_LastBoneInfoIndex = 0;
-    }
-    assert(m_BonesInfos[m_LastBoneInfoIndex].first == name);
-    return m_BonesInfos[m_LastBoneInfoIndex++].second;
+const BoneInfo *SkeletalAnimationData::GetNodeBoneInfo(int nodeIndex) const {
+    return m_BonesInfos[nodeIndex].second;
 }
 
 float SkeletalAnimationData::GetTicksPerSecond() {
@@ -1,4 +1,5 @@
 #include "skeletal_animations_manager.hpp"
+#include "asset_manager.hpp"
 
 SkeletalAnimationsManager::SkeletalAnimationsManager(SkeletalAnimationData* animation) {
     m_FinalBoneMatrices.reserve(MAX_BONES);
@@ -15,17 +16,7 @@ SkeletalAnimationsManager::SkeletalAnimationsManager(const std::string& animatio
         m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
     }
 
-    Assimp::Importer importer;
-    std::string finalPath = GetResourcePath(Resource::MODEL, animationPath);
-    const aiScene* scene = importer.ReadFile(finalPath, aiProcess_Triangulate | aiProcess_OptimizeGraph);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        Logger::Error("ERROR::ASSIMP::%s", importer.GetErrorString());
-        return;
-    }
-
-    for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
-        m_Animations.push_back(new SkeletalAnimationData(animationPath, scene, i, model));
-    }
+    AddAnimation(animationPath, model);
     m_CurrentAnimationIndex = -1;
 }
 
@@ -34,16 +25,13 @@ void SkeletalAnimationsManager::AddAnimation(SkeletalAnimationData* animation) {
 }
 
 void SkeletalAnimationsManager::AddAnimation(const std::string& animationPath, Model* model) {
-    Assimp::Importer importer;
-    std::string finalPath = GetResourcePath(Resource::MODEL, animationPath);
-    const aiScene* scene = importer.ReadFile(finalPath, aiProcess_Triangulate | aiProcess_OptimizeGraph);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        Logger::Error("ERROR::ASSIMP::%s", importer.GetErrorString());
+    // Scene is usually imported already by the model of the file
+    auto scene = AssetManager::LoadScene(animationPath);
+    if (!scene)
         return;
-    }
 
     for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
-        m_Animations.push_back(new SkeletalAnimationData(animationPath, scene, i, model));
+        m_Animations.push_back(new SkeletalAnimationData(animationPath, scene.get(), i, model));
     }
 }
 
@@ -97,7 +85,9 @@ void SkeletalAnimationsManager::Update(float dt) {
                 return;
             }
         }
-        CalculateBoneTransform(&(m_Animations[m_CurrentAnimationIndex]->GetRootNode()), glm::mat4(1.0f));
+        int nodeIndex = 0;
+        CalculateBoneTransform(&(m_Animations[m_CurrentAnimationIndex]->GetRootNode()), glm::mat4(1.0f),
+                               &nodeIndex);
     }
 }
 
@@ -106,26 +96,19 @@ const std::vector<glm::mat4> &SkeletalAnimationsManager::GetFinalBoneMatrices()
 }
 
 void SkeletalAnimationsManager::CalculateBoneTransform(
-        const AssimpNodeData* node, glm::mat4 parentTransform) {
-    std::string nodeName = node->name;
+        const AssimpNodeData* node, glm::mat4 parentTransform, int *nodeIndex) {
+    const SkeletalAnimationData *currentAnimation = m_Animations[m_CurrentAnimationIndex];
+    int index = (*nodeIndex)++;
     glm::mat4 nodeTransform = node->transformation;
-    auto m_CurrentAnimation = m_Animations[m_CurrentAnimationIndex];
-    Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
-
-    if (Bone) {
-        Bone->Update(m_CurrentTime);
-        nodeTransform = Bone->GetLocalTransform();
-    }
+    if (const Bone *bone = currentAnimation->GetNodeBone(index))
+        nodeTransform = bone->GetLocalTransform(m_CurrentTime);
 
     glm::mat4 globalTransformation = parentTransform * nodeTransform;
-    auto boneInfo = m_CurrentAnimation->FindBoneInfo(nodeName);
-    if (boneInfo != nullptr) {
-        int index = boneInfo->id;
-        glm::mat4 offset = boneInfo->offset;
-        assert(index < MAX_BONES);
-        m_FinalBoneMatrices[index] = globalTransformation * offset;
+    if (const BoneInfo *boneInfo = currentAnimation->GetNodeBoneInfo(index)) {
+        assert(boneInfo->id < MAX_BONES);
+        m_FinalBoneMatrices[boneInfo->id] = globalTransformation * boneInfo->offset;
     }
 
     for (int i = 0; i < node->children.size(); i++)
-        CalculateBoneTransform(&node->children[i], globalTransformation);
+        CalculateBoneTransform(&node->children[i], globalTransformation, nodeIndex);
 }
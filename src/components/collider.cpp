@@ -22,7 +22,6 @@ AABB Collider::GetDefaultAABB(Model* model) {
     Vec3 max = {-1e12, -1e12, -1e12};
 
     for (auto &m : model->meshes) {
-        int len = m.getLenArrPoints();
         for (auto &vertex : m.getVecPoints()) {
             min = glm::min(min, vertex.Position);
             max = glm::max(max, vertex.Position);
@@ -31,6 +30,33 @@ AABB Collider::GetDefaultAABB(Model* model) {
     return AABB{min, max};
 }
 
+AABB BoundsShifted(AABB aabb, Transform transform) {
+    return aabb.Transformed(transform);
+}
+
+AABB BoundsShifted(Sphere sphere, Transform transform) {
+    auto s = sphere.Transformed(transform);
+    return AABB{s.center - Vec3(s.radius), s.center + Vec3(s.radius)};
+}
+
+AABB BoundsShifted(OBB obb, Transform transform) {
+    auto o = obb.Transformed(transform);
+    Vec3 extents = glm::abs(o.axis[0]) * o.halfWidth[0]
+        + glm::abs(o.axis[1]) * o.halfWidth[1]
+        + glm::abs(o.axis[2]) * o.halfWidth[2];
+    return AABB{o.center - extents, o.center + extents};
+}
+
+AABB BoundsShifted(Mesh *mesh, Transform transform) {
+    const MeshBVH &bvh = mesh->GetBVH();
+    AABB local = bvh.IsEmpty() ? Collider::GetDefaultAABB(mesh) : bvh.GetBounds();
+    return local.TransformedBounds(transform.GetTransformMatrix());
+}
+
+AABB Collider::GetBounds(Transform self) {
+    return std::visit([=](auto shape) { return BoundsShifted(shape, self); }, shape);
+}
+
 template<typename U>
 bool CollideShifted(Ray lhs, U rhs, Transform rhsTransform) {
     return CollidePrimitive(lhs, rhs.Transformed(rhsTransform));
@@ -38,9 +64,7 @@ bool CollideShifted(Ray lhs, U rhs, Transform rhsTransform) {
 
 template<>
 bool CollideShifted(Ray lhs, Mesh* rhs, Transform rhsTransform) {
-    Logger::Error("Raycast into mesh is not supported yet");
-    assert(false);
-    return false;
+    return CollisionMeshAt(lhs, rhs, rhsTransform).has_value();
 }
 
 template<typename T, typename U>
@@ -86,10 +110,14 @@ std::optional<float> CollisionShifted(Ray lhs, U rhs, Transform rhsTransform) {
 
 template<>
 std::optional<float> CollisionShifted(Ray lhs, Mesh * rhs, Transform rhsTransform) {
-    Logger::Error("Raycast into mesh is not supported yet");
-    assert(false);
-    return {};
+    return CollisionMeshAt(lhs, rhs, rhsTransform);
 }
 std::optional<float> Collider::RaycastHit(Transform self, Ray ray) {
     return std::visit([=](auto shape) { return CollisionShifted(ray, shape, self); }, shape);
 }
+
+bool Collider::CanCollide(const Collider &a, const Collider &b) {
+    if (!(a.mask & b.layers) || !(b.mask & a.layers))
+        return false;
+    return a.motion == ColliderMotion::DYNAMIC || b.motion == ColliderMotion::DYNAMIC;
+}
@@ -1,77 +1,75 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <cstddef>
+#include <utility>
 
 #include "render_data.hpp"
+#include "vertex_layout.hpp"
 #include "logger.hpp"
+#include "backend.hpp"
 
-RenderMesh::RenderMesh(std::vector<Vertex> points, std::vector<unsigned int> indices, Material material) {
-    this->setPoints(points);
-    this->setIndices(indices);
-    this->material = material;
+MeshAsset::MeshAsset(std::vector<Vertex> points, std::vector<unsigned int> indices, bool skinned) {
+    auto storage = std::make_shared<std::pair<std::vector<Vertex>, std::vector<unsigned int>>>(
+        std::move(points), std::move(indices));
+    m_Points = ArrayView<Vertex>(storage->first.data(), storage->first.size());
+    m_Indices = ArrayView<unsigned int>(storage->second.data(), storage->second.size());
+    m_Storage = std::move(storage);
+    Upload(skinned);
+}
 
-    bindRenderData(this);
+MeshAsset::MeshAsset(std::shared_ptr<const void> storage, ArrayView<Vertex> points,
+                     ArrayView<unsigned int> indices, bool skinned)
+    : m_Storage(std::move(storage)), m_Points(points), m_Indices(indices) {
+    Upload(skinned);
 }
 
-RenderMesh::RenderMesh(Mesh *mesh, Material material) {
-    this->setPoints(mesh->getVecPoints());
-    this->setIndices(mesh->getVecIndices());
-    this->material = material;
+MeshAsset::~MeshAsset() {
+    if (m_VAO == 0)
+        return;
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+}
 
-    bindRenderData(this);
+ArrayView<Vertex> MeshAsset::GetPoints() const {
+    return m_Points;
 }
 
-void RenderMesh::setMaterial(Material material) {
-    this->material = material;
+ArrayView<unsigned int> MeshAsset::GetIndices() const {
+    return m_Indices;
 }
 
-void bindRenderData(RenderMesh* render_data) {
-    if (!render_data) {
-        Logger::Error("RENDER_DATA::BINDER::RENDER_MESH_ARE_NULL");
-    }
-    glGenVertexArrays(1, &render_data->VAO);
-    glGenBuffers(1, &render_data->VBO);
-    glGenBuffers(1, &render_data->EBO);
+unsigned int MeshAsset::GetVAO() const {
+    return m_VAO;
+}
+
+void MeshAsset::Upload(bool skinned) {
+    if (!Backend::HasGraphics())
+        return;
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
     // bind the Vertex Array Object first,
     // then bind and set vertex buffer(s),
     // and then configure vertex attributes(s).
 
-    glBindVertexArray(render_data->VAO);
+    glBindVertexArray(m_VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, render_data->VBO);
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        render_data->getLenArrPoints() * sizeof(Vertex),
-        render_data->getPoints(),
-        GL_STATIC_DRAW);
+    // Full layout is the CPU array itself, others are packed for the upload
+    const VertexLayout &layout = VertexLayout::For(skinned);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    if (&layout == &VertexLayout::Full()) {
+        glBufferData(GL_ARRAY_BUFFER, m_Points.size() * sizeof(Vertex), m_Points.data(), GL_STATIC_DRAW);
+    } else {
+        std::vector<unsigned char> packed(m_Points.size() * layout.stride);
+        layout.Pack(m_Points, packed.data());
+        glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, render_data->EBO);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        render_data->getLenIndices() * sizeof(unsigned int),
-        render_data->getIndices(),
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int), m_Indices.data(),
         GL_STATIC_DRAW);
 
-    // position attribute
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        reinterpret_cast<void*>(offsetof(Vertex, Position)));
-    // normal attribute
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        reinterpret_cast<void*>(offsetof(Vertex, Normal)));
-    // texture coordinates
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        reinterpret_cast<void*>(offsetof(Vertex, TexCoords)));
-    // ids
-    glEnableVertexAttribArray(3);
-    glVertexAttribIPointer(3, 4, GL_INT, sizeof(Vertex),
-        reinterpret_cast<void*>(offsetof(Vertex, m_BoneIDs)));
-    // weights
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        reinterpret_cast<void*>(offsetof(Vertex, m_Weights)));
+    layout.Bind();
 
     // note that this is allowed, the call to glVertexAttribPointer registered VBO as
     // the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
@@ -86,3 +84,34 @@ void bindRenderData(RenderMesh* render_data) {
     // so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
     glBindVertexArray(0);
 }
+
+RenderMesh::RenderMesh(std::vector<Vertex> points, std::vector<unsigned int> indices, Material material,
+                       bool skinned)
+    : material(material),
+      m_Asset(std::make_shared<const MeshAsset>(std::move(points), std::move(indices), skinned)) {}
+
+RenderMesh::RenderMesh(Mesh *mesh, Material material)
+    : RenderMesh(mesh->getVecPoints(), mesh->getVecIndices(), material) {}
+
+RenderMesh::RenderMesh(std::shared_ptr<const MeshAsset> asset, Material material)
+    : material(material), m_Asset(std::move(asset)) {}
+
+void RenderMesh::setMaterial(Material material) {
+    this->material = material;
+}
+
+const std::shared_ptr<const MeshAsset> &RenderMesh::getAsset() const {
+    return m_Asset;
+}
+
+ArrayView<Vertex> RenderMesh::getVecPoints() const {
+    return m_Asset->GetPoints();
+}
+
+int RenderMesh::getLenIndices() const {
+    return static_cast<int>(m_Asset->GetIndices().size());
+}
+
+unsigned int RenderMesh::getVAO() const {
+    return m_Asset->GetVAO();
+}
@@ -1,6 +1,7 @@
 #include "sound.hpp"
 #include "path_resolver.hpp"
 #include "bass.h"
+#include "backend.hpp"
 
 Sound::Sound(SoundType type, std::string path, bool looped) {
     path = GetResourcePath(Resource::SOUND, path);
@@ -9,6 +10,9 @@ Sound::Sound(SoundType type, std::string path, bool looped) {
 
     m_Type = type;
     m_Volume = 1.f;
+    m_Channel = 0;
+    if (!Backend::HasAudio())
+        return;
 
     if (type == SoundType::SOUND_FLAT) {
         sample = BASS_SampleLoad(false, path.c_str(), 0, 0, 10, loop);
@@ -1,5 +1,6 @@
 #include "transform.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 Transform::Transform(Vec3 translation, Vec3 scale, float radiansDegree,
                      Vec3 rotationAxis) {
@@ -14,33 +15,52 @@ Transform::Transform(Vec3 translation, Vec3 scale, Mat4 rotation) {
     this->m_Rotation = rotation;
 }
 
+Transform::Transform(const Transform &other) {
+    *this = other;
+}
+
+Transform &Transform::operator=(const Transform &other) {
+    m_Translation = other.m_Translation;
+    m_Scale = other.m_Scale;
+    m_Rotation = other.m_Rotation;
+    m_Dirty = true;
+    return *this;
+}
+
 // Translation
 void Transform::SetTranslation(Vec3 translation) {
+    m_Dirty = true;
     this->m_Translation = translation;
 }
 void Transform::Translate(Vec3 translate) {
+    m_Dirty = true;
     this->m_Translation += translate;
 }
 
 // Scale
 void Transform::SetScale(Vec3 scale) {
+    m_Dirty = true;
     this->m_Scale = scale;
 }
 
 void Transform::Scale(Vec3 scale) {
+    m_Dirty = true;
     this->m_Scale = this->m_Scale * scale;
 }
 
 // Rotate
 void Transform::SetRotation(float radiansDegree, Vec3 rotationAxis) {
+    m_Dirty = true;
     this->m_Rotation = glm::rotate(Mat4(1.0), radiansDegree, rotationAxis);
 }
 
 void Transform::SetRotation(Mat4 rotationMatrix) {
+    m_Dirty = true;
     this->m_Rotation = rotationMatrix;
 }
 
 void Transform::SetRotation(float radiansDegreeX, float radiansDegreeY, float radiansDegreeZ) {
+    m_Dirty = true;
     this->m_Rotation = Mat4(1.f);
     this->m_Rotation = glm::rotate(this->m_Rotation, radiansDegreeX, Vec3(1.0f, 0.f, 0.f));
     this->m_Rotation = glm::rotate(this->m_Rotation, radiansDegreeY, Vec3(0.0f, 1.f, 0.f));
@@ -48,47 +68,71 @@ void Transform::SetRotation(float radiansDegreeX, float radiansDegreeY, float ra
 }
 
 void Transform::Rotate(float radiansDegree, Vec3 rotationAxis) {
+    m_Dirty = true;
     this->m_Rotation = glm::rotate(this->m_Rotation, radiansDegree, rotationAxis);
 }
 
 void Transform::RotateGlobal(float radiansDegree, Vec3 rotationAxis) {
+    m_Dirty = true;
     auto axis = Mul(rotationAxis, m_Rotation);
     m_Rotation = glm::rotate(m_Rotation, radiansDegree, axis);
 }
 
 void Transform::Rotate(float radiansDegreeX, float radiansDegreeY, float radiansDegreeZ) {
+    m_Dirty = true;
     this->m_Rotation = glm::rotate(this->m_Rotation, radiansDegreeX, Vec3(1.0f, 0.f, 0.f));
     this->m_Rotation = glm::rotate(this->m_Rotation, radiansDegreeY, Vec3(0.0f, 1.f, 0.f));
     this->m_Rotation = glm::rotate(this->m_Rotation, radiansDegreeZ, Vec3(0.0f, 0.f, 1.f));
 }
 
 void Transform::RotateGlobal(float radiansDegreeX, float radiansDegreeY, float radiansDegreeZ) {
+    m_Dirty = true;
     m_Rotation = glm::rotate(m_Rotation, radiansDegreeX, Mul(Vec3(1.0f, 0.f, 0.f), m_Rotation));
     m_Rotation = glm::rotate(m_Rotation, radiansDegreeY, Mul(Vec3(0.0f, 1.f, 0.f), m_Rotation));
     m_Rotation = glm::rotate(m_Rotation, radiansDegreeZ, Mul(Vec3(0.0f, 0.f, 1.f), m_Rotation));
 }
 
 void Transform::Rotate(Mat4 rotationMatrix) {
+    m_Dirty = true;
     this->m_Rotation *= rotationMatrix;
 }
 
+bool Transform::IsDirty() {
+    return m_Dirty;
+}
+
+void Transform::ClearDirty() {
+    m_Dirty = false;
+}
+
 // Getters
-Vec3 Transform::GetTranslation() {
+Vec3 Transform::GetTranslation() const {
     return this->m_Translation;
 }
 
-Vec3 Transform::GetScale() {
+Vec3 Transform::GetScale() const {
     return this->m_Scale;
 }
 
-Mat4 Transform::GetRotation() {
+Mat4 Transform::GetRotation() const {
     return this->m_Rotation;
 }
 
-Mat4 Transform::GetTransformMatrix() {
+Mat4 Transform::GetTransformMatrix() const {
     Mat4 transformMatrix(1.0f);
     transformMatrix = glm::translate(transformMatrix, this->m_Translation);
     transformMatrix = transformMatrix * this->m_Rotation;
     transformMatrix = glm::scale(transformMatrix, this->m_Scale);
     return transformMatrix;
 }
+
+Mat4 InterpolateTransformMatrix(Transform &from, Transform &to, float alpha) {
+    glm::quat rotation = glm::slerp(glm::quat_cast(from.GetRotation()),
+                                    glm::quat_cast(to.GetRotation()), alpha);
+    Mat4 transformMatrix(1.0f);
+    transformMatrix = glm::translate(transformMatrix,
+                                     glm::mix(from.GetTranslation(), to.GetTranslation(), alpha));
+    transformMatrix = transformMatrix * glm::mat4_cast(rotation);
+    transformMatrix = glm::scale(transformMatrix, glm::mix(from.GetScale(), to.GetScale(), alpha));
+    return transformMatrix;
+}
@@ -5,6 +5,10 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
 
 #include "engine_config.hpp"
 #include "math_types.hpp"
@@ -44,35 +48,47 @@ Camera* Engine::SwitchCamera(Camera* newCamera) {
     return toReturn;
 }
 
+const RenderStats &Engine::GetRenderStats() const {
+    return m_RenderQueue.GetStats();
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 void processInput(GLFWwindow *window);
 
-Engine::Engine() {
+Engine::Engine(EngineMode mode) {
     camera = new Camera(Vec3(0.0f, 0.0f, 3.0f));
     s_Engine = this;
-    // Pre-allocate all needed memory
-    m_Transforms = ComponentArray<Transform>();
-    m_Models = ComponentArray<Model>();
-    m_Animations = ComponentArray<Animation>();
-    m_Colliders = ComponentArray<Collider>();
-    m_RigidBodies = ComponentArray<RigidBody>();
-    m_Images = ComponentArray<Image>();
-    m_Texts = ComponentArray<Text>();
-    m_SkeletalAnimationsManagers = ComponentArray<SkeletalAnimationsManager>();
-    m_Sounds = ComponentArray<Sound>();
-
-    m_PointLights = ComponentArray<PointLight>();
-    m_DirLights = ComponentArray<DirLight>();
-    m_SpotLights = ComponentArray<SpotLight>();
-    m_ObjectCount = 0;
-    m_Names.assign(MAX_OBJECT_COUNT, "default");
-
-    m_CollideCache = std::vector<std::vector<CollisionManifold>>(MAX_OBJECT_COUNT);
-    for (auto i = 0; i < MAX_OBJECT_COUNT; i++)
-        m_CollideCache[i] = std::vector<CollisionManifold>(MAX_OBJECT_COUNT);
+
+    // Rigid body update iterates these together every frame
+    m_Components.Group<RigidBody, Collider, Transform>();
+
+    // Systems that do not write components used by each other run concurrently.
+    // Physics systems run once per fixed step, the rest once per frame after them
+    m_Jobs = std::make_unique<JobSystem>();
+    m_PhysicsSystems.Add<Reads<>, Writes<Transform>>([this](float) { UpdateGlobalTransforms(); });
+    // Broadphase and contacts are collider state
+    m_PhysicsSystems.Add<Reads<Transform>, Writes<Collider>>([this](float) { UpdateCollisions(); });
+    m_PhysicsSystems.Add<Reads<Collider>, Writes<RigidBody, Transform>>(
+        [this](float dt) { ResolveCollisions(dt); });
+    m_PhysicsSystems.Add<Reads<Collider>, Writes<RigidBody, Transform>>(
+        [this](float dt) { UpdateRigidBodies(dt); });
+
+    m_Systems.Add<Reads<>, Writes<Animation, Transform>>([this](float dt) { UpdateAnimations(dt); });
+    m_Systems.Add<Reads<>, Writes<SkeletalAnimationsManager>>(
+        [this](float dt) { UpdateSkeletalAnimations(dt); });
+    m_Systems.Add<Reads<Transform>, Writes<Sound>>([this](float) { UpdateSounds(); });
+    // Behaviours may access anything and create objects
+    m_Systems.AddOnMainThread<Reads<>, Writes<AllComponents>>([this](float dt) { UpdateBehaviours(dt); });
+
+    m_Broadphase = std::make_unique<SweepAndPrune>();
+
+    m_Headless = mode == EngineMode::HEADLESS;
+    Backend::SetHeadless(m_Headless);
+    if (m_Headless)
+        return;
 
     bool bassInit = BASS_Init(-1, 44100, 0, NULL, NULL);
     if (!bassInit) {
@@ -102,23 +118,48 @@ Engine::Engine() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return;
     }
+
+    glGenBuffers(1, &m_LightsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_LightsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_UNIFORM_BINDING, m_LightsBuffer);
 }
 
 Engine::~Engine() {
-    for (auto &model : m_Models) {
-        for (auto mesh : model.meshes) {
-            glDeleteVertexArrays(1, &mesh.VAO);
-            glDeleteBuffers(1, &mesh.VBO);
-            glDeleteBuffers(1, &mesh.EBO);
-        }
-    }
+    if (m_Headless)
+        return;
+    glDeleteBuffers(1, &m_LightsBuffer);
     BASS_Free();
     std::cout << "Goodbye";
 }
 
-// TODO(theblek): reuse object ids
+ObjectHandle Engine::AllocateHandle() {
+    int index;
+    if (!m_FreeSlots.empty()) {
+        index = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    } else {
+        index = static_cast<int>(m_Generations.size());
+        if (index > HANDLE_INDEX_MASK) {
+            Logger::Error("ENGINE::OUT_OF_OBJECT_HANDLES!");
+            assert(false);
+        }
+        m_Generations.push_back(0);
+        m_Names.emplace_back();
+    }
+    return MakeHandle(index, m_Generations[index]);
+}
+
+void Engine::FreeHandle(ObjectHandle handle) {
+    int index = GetHandleIndex(handle);
+    // Handles to the removed object become stale
+    m_Generations[index] = (m_Generations[index] + 1) & HANDLE_GENERATION_MASK;
+    m_FreeSlots.push_back(index);
+}
+
 Object Engine::NewObject() {
-    ObjectHandle handle = m_ObjectCount++;
+    ObjectHandle handle = AllocateHandle();
+    m_Names[GetHandleIndex(handle)] = "default";
     m_NamesToHandles["default"].push_back(handle);
     Logger::Info("Created object %d with \"default\" name", handle);
     AddChild(ROOT, handle);
@@ -126,8 +167,8 @@ Object Engine::NewObject() {
 }
 
 Object Engine::NewObject(std::string name) {
-    ObjectHandle handle = m_ObjectCount++;
-    m_Names[handle] = name;
+    ObjectHandle handle = AllocateHandle();
+    m_Names[GetHandleIndex(handle)] = name;
     m_NamesToHandles[name].push_back(handle);
     Logger::Info("Created object %d, named \"%s\"", handle, name.c_str());
     AddChild(ROOT, handle);
@@ -135,7 +176,7 @@ Object Engine::NewObject(std::string name) {
 }
 
 void Engine::SetObjectName(ObjectHandle handle, std::string name) {
-    std::string oldName = m_Names[handle];
+    std::string oldName = m_Names[GetHandleIndex(handle)];
     for (auto it = m_NamesToHandles[oldName].begin(); it != m_NamesToHandles[oldName].end(); it++) {
         if (*it == handle) {
             m_NamesToHandles[oldName].erase(it);
@@ -146,12 +187,12 @@ void Engine::SetObjectName(ObjectHandle handle, std::string name) {
         m_NamesToHandles.erase(oldName);
     }
 
-    m_Names[handle] = name;
+    m_Names[GetHandleIndex(handle)] = name;
     m_NamesToHandles[name].push_back(handle);
 }
 
 std::string Engine::GetObjectName(ObjectHandle handle) {
-    return m_Names[handle];
+    return m_Names[GetHandleIndex(handle)];
 }
 
 std::vector<ObjectHandle> Engine::GetHandlesByName(std::string name) {
@@ -159,42 +200,29 @@ std::vector<ObjectHandle> Engine::GetHandlesByName(std::string name) {
 }
 
 bool Engine::IsObjectValid(ObjectHandle obj) {
-    return m_Parents.HasData(obj);
+    if (obj < 0 || GetHandleIndex(obj) >= m_Generations.size())
+        return false;
+    return GetHandleGeneration(obj) == m_Generations[GetHandleIndex(obj)];
 }
 
 void Engine::RemoveObject(ObjectHandle handle) {
-    if (m_Transforms.HasData(handle))
-        m_Transforms.RemoveData(handle);
-    if (m_Models.HasData(handle))
-        m_Models.RemoveData(handle);
-    if (m_Colliders.HasData(handle))
-        m_Colliders.RemoveData(handle);
-    if (m_RigidBodies.HasData(handle))
-        m_RigidBodies.RemoveData(handle);
-    if (m_Texts.HasData(handle))
-        m_Texts.RemoveData(handle);
-    if (m_Images.HasData(handle))
-        m_Images.RemoveData(handle);
-    if (m_Animations.HasData(handle))
-        m_Animations.RemoveData(handle);
-    if (m_SpotLights.HasData(handle))
-        m_SpotLights.RemoveData(handle);
-    if (m_PointLights.HasData(handle))
-        m_PointLights.RemoveData(handle);
-    if (m_DirLights.HasData(handle))
-        m_DirLights.RemoveData(handle);
-    if (m_Behaviours.HasData(handle))
-        m_Behaviours.RemoveData(handle);
-
-    for (auto it = m_NamesToHandles[m_Names[handle]].begin();
-              it != m_NamesToHandles[m_Names[handle]].end(); it++) {
+    if (!IsObjectValid(handle)) {
+        Logger::Warn("Trying to remove object %d, which was already removed", handle);
+        return;
+    }
+    m_Components.RemoveAll(handle);
+    m_Broadphase->Remove(handle);
+
+    std::string &name = m_Names[GetHandleIndex(handle)];
+    auto &sameName = m_NamesToHandles[name];
+    for (auto it = sameName.begin(); it != sameName.end(); it++) {
         if (*it == handle) {
-            m_NamesToHandles[m_Names[handle]].erase(it);
+            sameName.erase(it);
             break;
         }
     }
-    if (m_NamesToHandles[m_Names[handle]].empty()) {
-        m_NamesToHandles.erase(m_Names[handle]);
+    if (sameName.empty()) {
+        m_NamesToHandles.erase(name);
     }
 
 
@@ -202,21 +230,28 @@ void Engine::RemoveObject(ObjectHandle handle) {
         auto parent = m_Parents.GetData(handle);
         if (parent != ROOT) {
             auto &children = m_Children.GetData(parent);
-            children.erase(std::find(children.begin(), children.end(), parent));
+            children.erase(std::find(children.begin(), children.end(), handle));
         }
         m_Parents.RemoveData(handle);
     }
     if (m_Children.HasData(handle)) {
-        for (auto child : m_Children.GetData(handle))
+        // Children erase themselves from the list, so iterate over a copy
+        auto children = m_Children.GetData(handle);
+        for (auto child : children)
             RemoveObject(child);
         m_Children.RemoveData(handle);
     }
+    m_HierarchyChanged = true;
+    m_TransformsTouched = true;
+    FreeHandle(handle);
 }
 
 void Engine::AddChild(ObjectHandle parent, ObjectHandle child) {
     assert(child != ROOT && "Adding root as child to anything is ~~stuuupid~~ unexpected");
     // TODO(theblek): Check for cycles in the tree
     m_Parents.SetData(child, parent);
+    m_HierarchyChanged = true;
+    m_TransformsTouched = true;
     if (parent == ROOT) return;
     if (!m_Children.HasData(parent))
         m_Children.SetData(parent, std::vector<ObjectHandle>());
@@ -228,183 +263,307 @@ Object Engine::GetParent(ObjectHandle node) {
 }
 
 Transform *Engine::GetTransform(ObjectHandle handle) {
-    return m_Transforms.HasData(handle) ? &m_Transforms.GetData(handle) : nullptr;
+    Touch<Transform>(handle);
+    return m_Components.Get<Transform>(handle);
 }
 
 Model *Engine::GetModel(ObjectHandle handle) {
-    return m_Models.HasData(handle) ? &m_Models.GetData(handle) : nullptr;
+    return m_Components.Get<Model>(handle);
+}
+
+// Builds global transform from world matrix. Scale is accumulated separately
+// because it can't be restored from the matrix when rotation is present.
+static Transform DecomposeWorldMatrix(Mat4 modelMat, Vec3 scale) {
+    Transform result;
+    result.SetScale(scale);
+    result.SetTranslation(Vec3{modelMat[3][0], modelMat[3][1], modelMat[3][2]});
+    modelMat[3][0] = modelMat[3][1] = modelMat[3][2] = 0;
+    modelMat[3][3] = 1;
+    result.SetRotation(glm::scale(modelMat, Vec3{1/scale.x, 1/scale.y, 1/scale.z}));
+    return result;
 }
 
 Transform Engine::GetGlobalTransform(ObjectHandle handle) {
-    auto transform = GetTransform(handle);
+    auto transform = m_Components.Get<Transform>(handle);
     if (!transform) {
         Logger::Error("Failed to get global transform: No transform on object");
         return Transform();
     }
 
+    // Cached value is valid unless the object or one of its ancestors has changed
+    // since the last update
+    if (!m_HierarchyChanged && GetHandleIndex(handle) < m_HandleToHierarchy.size()) {
+        int index = m_HandleToHierarchy[GetHandleIndex(handle)];
+        bool valid = index != -1 && m_HasWorld[index];
+        for (int cur = index; valid && cur != -1; cur = m_HierarchyParent[cur]) {
+            ObjectHandle ancestor = m_HierarchyOrder[cur];
+            // Transform was added or removed since the last update
+            if (m_HasWorld[cur] != m_Components.Has<Transform>(ancestor))
+                valid = false;
+            else if (!m_HasWorld[cur])
+                break;
+            else if (m_Components.Get<Transform>(ancestor)->IsDirty())
+                valid = false;
+        }
+        if (valid)
+            return m_GlobalTransforms[index];
+    }
+
     Mat4 modelMat = transform->GetTransformMatrix();
-    auto cur = Object(this, handle);
+    ObjectHandle cur = handle;
     Vec3 scale = transform->GetScale();
-    while (cur.GetParent().IsValid()) {
-        auto pTransform = cur.GetParent().GetTransform();
+    while (m_Parents.HasData(cur)) {
+        cur = m_Parents.GetData(cur);
+        auto pTransform = m_Components.Get<Transform>(cur);
         if (!pTransform) break;
-        cur = cur.GetParent();
         modelMat = pTransform->GetTransformMatrix() * modelMat;
         scale *= pTransform->GetScale();
     }
-    Transform result;
-    result.SetScale(scale);
-    result.SetTranslation(Vec3{modelMat[3][0], modelMat[3][1], modelMat[3][2]});
-    modelMat[3][0] = modelMat[3][1] = modelMat[3][2] = 0;
-    modelMat[3][3] = 1;
-    result.SetRotation(glm::scale(modelMat, Vec3{1/scale.x, 1/scale.y, 1/scale.z}));
+    return DecomposeWorldMatrix(modelMat, scale);
+}
 
-    return result;
+void Engine::UpdateHierarchyOrder() {
+    m_HierarchyOrder.clear();
+    m_HierarchyParent.clear();
+    m_HandleToHierarchy.assign(m_Generations.size(), -1);
+
+    auto push = [&](ObjectHandle handle, int parent) {
+        m_HandleToHierarchy[GetHandleIndex(handle)] = static_cast<int>(m_HierarchyOrder.size());
+        m_HierarchyOrder.push_back(handle);
+        m_HierarchyParent.push_back(parent);
+    };
+
+    for (int i = 0; i < m_Parents.GetSize(); i++) {
+        if (m_Parents.entries[i] == ROOT)
+            push(m_Parents.GetFromInternal(i), -1);
+    }
+    // Breadth-first traversal puts parents before children
+    for (int i = 0; i < m_HierarchyOrder.size(); i++) {
+        ObjectHandle handle = m_HierarchyOrder[i];
+        if (!m_Children.HasData(handle))
+            continue;
+        for (auto child : m_Children.GetData(handle))
+            push(child, i);
+    }
+
+    m_WorldMatrices.resize(m_HierarchyOrder.size());
+    m_GlobalTransforms.resize(m_HierarchyOrder.size());
+    m_HasWorld.assign(m_HierarchyOrder.size(), false);
+    m_WorldChanged.assign(m_HierarchyOrder.size(), false);
+    m_HierarchyChanged = false;
+}
+
+void Engine::UpdateGlobalTransforms() {
+    if (m_HierarchyChanged)
+        UpdateHierarchyOrder();
+
+    for (int i = 0; i < m_HierarchyOrder.size(); i++) {
+        ObjectHandle handle = m_HierarchyOrder[i];
+        int parent = m_HierarchyParent[i];
+        m_WorldChanged[i] = false;
+
+        Transform *local = m_Components.Get<Transform>(handle);
+        if (!local) {
+            // Children have to be recomputed if transform was just removed
+            m_WorldChanged[i] = m_HasWorld[i];
+            m_HasWorld[i] = false;
+            if (m_WorldChanged[i] && m_Components.Has<Collider>(handle))
+                m_MovedColliders.push_back(handle);
+            continue;
+        }
+
+        // Objects without transform break the chain, as in GetGlobalTransform
+        bool hasParent = parent != -1 && m_HasWorld[parent];
+        bool parentChanged = parent != -1 && m_WorldChanged[parent];
+        if (m_HasWorld[i] && !parentChanged && !local->IsDirty())
+            continue;
+
+        Mat4 world = local->GetTransformMatrix();
+        Vec3 scale = local->GetScale();
+        if (hasParent) {
+            world = m_WorldMatrices[parent] * world;
+            scale *= m_GlobalTransforms[parent].GetScale();
+        }
+        m_WorldMatrices[i] = world;
+        m_GlobalTransforms[i] = DecomposeWorldMatrix(world, scale);
+        m_HasWorld[i] = true;
+        m_WorldChanged[i] = true;
+        local->ClearDirty();
+        if (m_Components.Has<Collider>(handle))
+            m_MovedColliders.push_back(handle);
+    }
 }
 
 Collider *Engine::GetCollider(ObjectHandle handle) {
-    return m_Colliders.HasData(handle) ? &m_Colliders.GetData(handle) : nullptr;
+    Touch<Collider>(handle);
+    return m_Components.Get<Collider>(handle);
 }
 
 RigidBody *Engine::GetRigidBody(ObjectHandle handle) {
-    return m_RigidBodies.HasData(handle) ? &m_RigidBodies.GetData(handle) : nullptr;
+    return m_Components.Get<RigidBody>(handle);
 }
 
 Animation *Engine::GetAnimation(ObjectHandle handle) {
-    return m_Animations.HasData(handle) ? &m_Animations.GetData(handle) : nullptr;
+    return m_Components.Get<Animation>(handle);
 }
 
 Text *Engine::GetText(ObjectHandle handle) {
-    return m_Texts.HasData(handle) ? &m_Texts.GetData(handle) : nullptr;
+    return m_Components.Get<Text>(handle);
 }
 
 SkeletalAnimationsManager *Engine::GetSkeletalAnimationsManager(ObjectHandle handle) {
-    return m_SkeletalAnimationsManagers.HasData(handle) ?
-        &m_SkeletalAnimationsManagers.GetData(handle) : nullptr;
+    return m_Components.Get<SkeletalAnimationsManager>(handle);
 }
 
 Image *Engine::GetImage(ObjectHandle handle) {
-    return m_Images.HasData(handle) ? &m_Images.GetData(handle) : nullptr;
+    return m_Components.Get<Image>(handle);
 }
 
 Sound *Engine::GetSound(ObjectHandle handle) {
-    return m_Sounds.HasData(handle) ? &m_Sounds.GetData(handle) : nullptr;
+    return m_Components.Get<Sound>(handle);
 }
 
 PointLight *Engine::GetPointLight(ObjectHandle handle) {
-    return m_PointLights.HasData(handle) ? &m_PointLights.GetData(handle) : nullptr;
+    return m_Components.Get<PointLight>(handle);
 }
 
 SpotLight *Engine::GetSpotLight(ObjectHandle handle) {
-    return m_SpotLights.HasData(handle) ? &m_SpotLights.GetData(handle) : nullptr;
+    return m_Components.Get<SpotLight>(handle);
 }
 
 DirLight *Engine::GetDirLight(ObjectHandle handle) {
-    return m_DirLights.HasData(handle) ? &m_DirLights.GetData(handle) : nullptr;
+    return m_Components.Get<DirLight>(handle);
 }
 
 Behaviour *Engine::GetBehaviour(ObjectHandle handle) {
-    return m_Behaviours.HasData(handle) ? m_Behaviours.GetData(handle) : nullptr;
+    return m_Components.Has<Behaviour *>(handle) ? *m_Components.Get<Behaviour *>(handle) : nullptr;
 }
 
 Transform &Engine::AddTransform(ObjectHandle id, Transform v) {
-    m_Transforms.SetData(id, v);
-    return m_Transforms.GetData(id);
+    return Add<Transform>(id, std::move(v));
 }
 
 Model &Engine::AddModel(ObjectHandle id, Model v) {
-    m_Models.SetData(id, v);
-    return m_Models.GetData(id);
+    return Add<Model>(id, std::move(v));
 }
 
 Collider &Engine::AddCollider(ObjectHandle id, Collider v) {
-    m_Colliders.SetData(id, v);
-    return m_Colliders.GetData(id);
+    return Add<Collider>(id, std::move(v));
 }
 
 RigidBody &Engine::AddRigidBody(ObjectHandle id, RigidBody v) {
-    m_RigidBodies.SetData(id, v);
-    return m_RigidBodies.GetData(id);
+    return Add<RigidBody>(id, std::move(v));
 }
 
 Text &Engine::AddText(ObjectHandle id, Text v) {
-    m_Texts.SetData(id, v);
-    return m_Texts.GetData(id);
+    return Add<Text>(id, std::move(v));
 }
 
 SkeletalAnimationsManager &Engine::AddSkeletalAnimationsManager
     (ObjectHandle id, SkeletalAnimationsManager v) {
-    m_SkeletalAnimationsManagers.SetData(id, v);
-    return m_SkeletalAnimationsManagers.GetData(id);
+    return Add<SkeletalAnimationsManager>(id, std::move(v));
 }
 
 Image &Engine::AddImage(ObjectHandle id, Image v) {
-    m_Images.SetData(id, v);
-    return m_Images.GetData(id);
+    return Add<Image>(id, std::move(v));
 }
 
 Sound &Engine::AddSound(ObjectHandle id, Sound v) {
-    m_Sounds.SetData(id, v);
-    return m_Sounds.GetData(id);
+    return Add<Sound>(id, std::move(v));
 }
 
 Animation &Engine::AddAnimation(ObjectHandle id, Animation v) {
-    m_Animations.SetData(id, v);
-    return m_Animations.GetData(id);
+    return Add<Animation>(id, std::move(v));
 }
 
 PointLight &Engine::AddPointLight(ObjectHandle id, PointLight v) {
-    m_PointLights.SetData(id, v);
-    return m_PointLights.GetData(id);
+    return Add<PointLight>(id, std::move(v));
 }
 
 SpotLight &Engine::AddSpotLight(ObjectHandle id, SpotLight v) {
-    m_SpotLights.SetData(id, v);
-    return m_SpotLights.GetData(id);
+    return Add<SpotLight>(id, std::move(v));
 }
 
 DirLight &Engine::AddDirLight(ObjectHandle id, DirLight v) {
-    m_DirLights.SetData(id, v);
-    return m_DirLights.GetData(id);
+    return Add<DirLight>(id, std::move(v));
 }
 
 bool Engine::Collide(ObjectHandle a, ObjectHandle b) {
-    if (!m_Colliders.HasData(a) || !m_Colliders.HasData(b)) {
+    if (!m_Components.Has<Collider>(a) || !m_Components.Has<Collider>(b)) {
         Logger::Warn("Trying to get collision data on objects with no colliders");
         return false;
     }
-    return m_CollideCache[a][b].collide;
+    return m_Contacts.Find(a, b) != nullptr;
 }
 
 std::vector<Object> Engine::CollideAll(ObjectHandle a) {
     std::vector<Object> res;
-    for (int i = 0; i < m_Colliders.GetSize(); i++) {
-       auto handle = m_Colliders.GetFromInternal(i);
-       if (handle != a && Collide(a, handle)) {
-           res.push_back(Object(this, handle));
-       }
+    auto [first, last] = m_Contacts.GetContacts(a);
+    for (auto contact = first; contact != last; contact++) {
+        if (m_Components.Has<Collider>(contact->b))
+            res.push_back(Object(this, contact->b));
     }
     return res;
 }
 
 std::optional<ObjectHandle> Engine::GlobalRaycast(Ray ray) {
+    SyncMovedColliders();
+    m_Broadphase->Refresh();
+    return CastRay(ray);
+}
+
+void Engine::GlobalRaycast(const std::vector<Ray> &rays, std::vector<std::optional<ObjectHandle>> *out) {
+    SyncMovedColliders();
+    m_Broadphase->Refresh();
+    out->resize(rays.size());
+    m_Jobs->ParallelFor(static_cast<int>(rays.size()), [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            (*out)[i] = CastRay(rays[i]);
+    });
+}
+
+std::optional<ObjectHandle> Engine::CastRay(const Ray &ray) {
     std::optional<ObjectHandle> result = std::nullopt;
-    float bestDistance = 1e18;
-    for (int i = 0; i < m_Colliders.GetSize(); i++) {
-        int handle = m_Colliders.GetFromInternal(i);
-        auto current = m_Colliders.GetData(handle).RaycastHit(
-            m_Transforms.GetData(handle), ray);
-
-        if (!current.has_value()) continue;
-        if (current.value() < bestDistance) {
+    float bestDistance = std::numeric_limits<float>::max();
+    // Only colliders whose bounds the ray enters before the best hit are tested
+    m_Broadphase->Raycast(ray, bestDistance, [&](ObjectHandle handle, float entry) {
+        auto collider = m_Components.Get<Collider>(handle);
+        if (!collider || entry >= bestDistance)
+            return bestDistance;
+        auto current = collider->RaycastHit(m_ColliderTransforms[GetHandleIndex(handle)], ray);
+        if (current.has_value() && current.value() < bestDistance) {
             bestDistance = current.value();
-            result = m_Colliders.GetFromInternal(i);
+            result = handle;
         }
-    }
+        return bestDistance;
+    });
     return result;
 }
 
+void Engine::SetBroadphase(std::unique_ptr<Broadphase> broadphase) {
+    if (!broadphase) {
+        Logger::Error("ENGINE::ARGUMENT_IN_SETBROADPHASE_NULL!");
+        return;
+    }
+    m_Broadphase = std::move(broadphase);
+    m_CollisionPairs.clear();
+}
+
+void Engine::SetWorkerCount(int count) {
+    m_Jobs = std::make_unique<JobSystem>(count);
+}
+
+void Engine::Step(float deltaTime) {
+    Time::SetDeltaTime(deltaTime);
+    updateObjects(deltaTime);
+    AssetManager::ProcessUploads(ASSET_UPLOAD_BUDGET);
+}
+
 void Engine::Run() {
+    if (m_Headless) {
+        Logger::Error("ENGINE::RUN_IN_HEADLESS_MODE, use Step instead");
+        return;
+    }
     scrWidth = SCR_WIDTH;
     scrHeight = SCR_HEIGHT;
     viewportWidth = SCR_WIDTH;
@@ -438,6 +597,11 @@ void Engine::Run() {
         if (currentTime - lastFpsShowedTime > FPS_SHOWING_INTERVAL) {
             fps = static_cast<unsigned int>(fpsFrames / (currentTime - lastFpsShowedTime));
             Logger::Info("FPS: %d", fps);
+            const RenderStats &stats = m_RenderQueue.GetStats();
+            Logger::Info("Draw calls: %d, program changes: %d, texture changes: %d, "
+                         "vertex array changes: %d, material changes: %d, culled objects: %d",
+                         stats.drawCalls, stats.programChanges, stats.textureChanges,
+                         stats.vertexArrayChanges, stats.materialChanges, stats.culledObjects);
             Time::SetCurrentFps(fps);
             lastFpsShowedTime = currentTime;
             fpsFrames = 0;
@@ -450,11 +614,19 @@ void Engine::Run() {
         camera->Update(&m_Input, deltaTime);
         updateObjects(deltaTime);
 
-        while (static_cast<int>(floor(static_cast<float>(glfwGetTime()) / frameTime)) == lastRenderedFrame) {
+        // Wait for the next frame slot. Sleep is coarse, so the end of the wait is yielded
+        double nextFrameTime = (lastRenderedFrame + 1) * static_cast<double>(frameTime);
+        for (double now = glfwGetTime(); now < nextFrameTime; now = glfwGetTime()) {
+            if (nextFrameTime - now > FRAME_PACER_YIELD_TIME)
+                std::this_thread::sleep_for(
+                    std::chrono::duration<double>(nextFrameTime - now - FRAME_PACER_YIELD_TIME));
+            else
+                std::this_thread::yield();
         }
 
         fpsFrames++;
         lastRenderedFrame = static_cast<int>(floor(static_cast<float>(glfwGetTime()) / frameTime));
+        AssetManager::ProcessUploads(ASSET_UPLOAD_BUDGET);
         Render(viewportWidth, viewportHeight);
     }
 
@@ -463,89 +635,240 @@ void Engine::Run() {
 }
 
 void Engine::updateObjects(float deltaTime) {
-    // Check collisions
-    for (int i = 0; i < m_Colliders.GetSize(); i++) {
-        auto handle = m_Colliders.GetFromInternal(i);
-        for (int j = i + 1; j < m_Colliders.GetSize(); j++) {
-            auto handle2 = m_Colliders.GetFromInternal(j);
-            auto c1 = m_Colliders.GetData(handle);
-            auto c2 = m_Colliders.GetData(handle2);
-            auto t1 = GetGlobalTransform(handle);
-            auto t2 = GetGlobalTransform(handle2);
-            m_CollideCache[handle][handle2] = c1.Collide(t1, &c2, t2);
-            m_CollideCache[handle2][handle] = m_CollideCache[handle][handle2];
-        }
+    // Physics advances in fixed steps, the remainder is carried to the next frame
+    m_PhysicsAccumulator += deltaTime;
+    int steps = 0;
+    while (m_PhysicsAccumulator >= m_PhysicsStep && steps < MAX_PHYSICS_STEPS) {
+        SavePhysicsState();
+        m_PhysicsSystems.Run(m_Jobs.get(), m_PhysicsStep);
+        m_PhysicsAccumulator -= m_PhysicsStep;
+        steps++;
     }
+    // Simulation can not keep up, slow it down instead of falling further behind
+    if (m_PhysicsAccumulator >= m_PhysicsStep)
+        m_PhysicsAccumulator = std::fmod(m_PhysicsAccumulator, m_PhysicsStep);
 
-    // Find collisions on rigidbodies and handle them
-    for (int i = 0; i < m_RigidBodies.GetSize(); i++) {
-        auto handle = m_RigidBodies.GetFromInternal(i);
-        if (!m_Colliders.HasData(handle) || !m_Transforms.HasData(handle)) {
-            Logger::Error(
-                "RigidBody on object %d must have a collider and a transform to work",
-                handle);
+    m_Systems.Run(m_Jobs.get(), deltaTime);
+    // Systems move transforms without going through accessors
+    m_TransformsTouched = true;
+}
+
+void Engine::SavePhysicsState() {
+    m_PreviousTransforms.resize(m_Generations.size());
+    m_PreviousHandles.resize(m_Generations.size(), -1);
+    m_Components.Each<RigidBody, Collider, Transform>(
+        [&](ObjectHandle handle, RigidBody &, Collider &, Transform &transform) {
+            int slot = GetHandleIndex(handle);
+            m_PreviousTransforms[slot] = transform;
+            m_PreviousHandles[slot] = handle;
+        });
+}
+
+void Engine::InterpolateRenderMatrices(float alpha) {
+    m_RenderMatrices.resize(m_HierarchyOrder.size());
+    m_RenderInterpolated.resize(m_HierarchyOrder.size());
+    for (int i = 0; i < m_HierarchyOrder.size(); i++) {
+        ObjectHandle handle = m_HierarchyOrder[i];
+        int parent = m_HierarchyParent[i];
+        m_RenderInterpolated[i] = false;
+        if (!m_HasWorld[i])
+            continue;
+
+        int slot = GetHandleIndex(handle);
+        bool hasPrevious = slot < m_PreviousHandles.size() && m_PreviousHandles[slot] == handle
+            && m_Components.Has<RigidBody>(handle);
+        bool hasParent = parent != -1 && m_HasWorld[parent];
+        if (!hasPrevious && !(hasParent && m_RenderInterpolated[parent])) {
+            m_RenderMatrices[i] = m_WorldMatrices[i];
             continue;
         }
-        for (int j = i + 1; j < m_RigidBodies.GetSize(); j++) {
-            auto handle2 = m_RigidBodies.GetFromInternal(j);
-            if (!m_Colliders.HasData(handle2) || !m_Transforms.HasData(handle2)) {
-                Logger::Error(
-                    "RigidBody on object %d must have a collider and a transform to work",
-                    handle2);
-                continue;
-            }
-
-            if (Collide(handle, handle2)) {
-                auto c1 = m_Colliders.GetData(handle);
-                auto c2 = m_Colliders.GetData(handle2);
-                auto t1 = GetGlobalTransform(handle);
-                auto t2 = GetGlobalTransform(handle2);
-                m_RigidBodies.GetData(handle).ResolveCollisions(
-                        &m_RigidBodies.GetData(handle2),
-                        m_CollideCache[handle][handle2],
-                        t1, t2, m_Transforms.GetData(handle),
-                        m_Transforms.GetData(handle2), deltaTime);
-            }
+
+        Transform &local = *m_Components.Get<Transform>(handle);
+        Mat4 localMat = hasPrevious
+            ? InterpolateTransformMatrix(m_PreviousTransforms[slot], local, alpha)
+            : local.GetTransformMatrix();
+        m_RenderMatrices[i] = hasParent ? m_RenderMatrices[parent] * localMat : localMat;
+        m_RenderInterpolated[i] = true;
+    }
+}
+
+void Engine::SetPhysicsTickRate(float ticksPerSecond) {
+    if (ticksPerSecond <= 0.f) {
+        Logger::Error("ENGINE::PHYSICS_TICK_RATE_MUST_BE_POSITIVE %f", ticksPerSecond);
+        return;
+    }
+    m_PhysicsStep = 1.f / ticksPerSecond;
+}
+
+// Global transform is computed once per collider and reused by narrowphase
+void Engine::SyncCollider(ObjectHandle handle, Collider &collider) {
+    if (!m_Components.Has<Transform>(handle)) {
+        m_Broadphase->Remove(handle);
+        return;
+    }
+    Transform &transform = m_ColliderTransforms[GetHandleIndex(handle)];
+    transform = GetGlobalTransform(handle);
+    m_Broadphase->Update(handle, collider.GetBounds(transform));
+}
+
+void Engine::SyncColliders() {
+    // Update bounds in broadphase
+    auto &colliders = m_Components.GetArray<Collider>();
+    m_ColliderTransforms.resize(m_Generations.size());
+    for (int i = 0; i < colliders.GetSize(); i++)
+        SyncCollider(colliders.GetFromInternal(i), colliders.entries[i]);
+    m_MovedColliders.clear();
+    m_AllCollidersTouched = false;
+}
+
+void Engine::SyncMovedColliders() {
+    if (m_AllCollidersTouched) {
+        UpdateGlobalTransforms();
+        SyncColliders();
+        m_TransformsTouched = false;
+        return;
+    }
+    if (!m_TransformsTouched)
+        return;
+    // Finds changed transforms and records colliders they move
+    UpdateGlobalTransforms();
+    m_ColliderTransforms.resize(m_Generations.size());
+    for (auto handle : m_MovedColliders) {
+        if (auto collider = m_Components.Get<Collider>(handle))
+            SyncCollider(handle, *collider);
+    }
+    m_MovedColliders.clear();
+    m_TransformsTouched = false;
+}
+
+void Engine::UpdateCollisions() {
+    SyncColliders();
+    auto &colliders = m_Components.GetArray<Collider>();
+
+    m_CollisionPairs.clear();
+    m_Broadphase->FindPairs(&m_CollisionPairs);
+    // Masked out pairs and pairs where nothing moves are dropped before narrowphase
+    auto rejected = std::remove_if(m_CollisionPairs.begin(), m_CollisionPairs.end(),
+        [&](const BroadphasePair &pair) {
+            return !Collider::CanCollide(colliders.GetData(pair.a), colliders.GetData(pair.b));
+        });
+    m_CollisionPairs.erase(rejected, m_CollisionPairs.end());
+
+    // Check collisions only on pairs with overlapping bounds.
+    // Pairs are independent, contacts are added in pair order afterwards
+    m_Narrowphase.Collide(m_CollisionPairs, &colliders, m_ColliderTransforms, m_Jobs.get(), &m_PairManifolds);
+
+    m_Contacts.Clear();
+    for (int i = 0; i < m_CollisionPairs.size(); i++) {
+        if (!m_PairManifolds[i].collide)
+            continue;
+        m_Contacts.Add(m_CollisionPairs[i].a, m_CollisionPairs[i].b, m_PairManifolds[i]);
+        // Dynamic collider touching a sleeping one wakes it up
+        for (ObjectHandle handle : {m_CollisionPairs[i].a, m_CollisionPairs[i].b}) {
+            auto &collider = colliders.GetData(handle);
+            if (collider.motion == ColliderMotion::SLEEPING)
+                collider.motion = ColliderMotion::DYNAMIC;
         }
     }
+    m_Contacts.Finalize();
+}
 
-    // Update Animations
-    for (int i = 0; i < m_Animations.GetSize(); i++) {
-        ObjectHandle handle = m_Animations.GetFromInternal(i);
-        if (!m_Transforms.HasData(handle)) {
-            Logger::Error(
-                "Animation component on object %d requires transform component to work",
-                handle);
+// Body of a collider that is not dynamic takes part in resolution as this copy:
+// infinite mass and no velocity, whatever mass the body itself has
+static RigidBody StillCopy(const RigidBody &body) {
+    RigidBody still = body;
+    still.massInverse = 0.f;
+    still.velocity = Vec3(0.f);
+    still.angularVelocity = Vec3(0.f);
+    return still;
+}
+
+void Engine::ResolveCollisions(float deltaTime) {
+    // Handle collisions on rigidbodies, every pair is visited once
+    for (auto &contact : m_Contacts) {
+        if (contact.a > contact.b)
+            continue;
+        auto body1 = m_Components.Get<RigidBody>(contact.a);
+        auto body2 = m_Components.Get<RigidBody>(contact.b);
+        if (!body1 || !body2)
             continue;
+
+        auto t1 = GetGlobalTransform(contact.a);
+        auto t2 = GetGlobalTransform(contact.b);
+        Transform *tr1 = m_Components.Get<Transform>(contact.a);
+        Transform *tr2 = m_Components.Get<Transform>(contact.b);
+        // Static and sleeping bodies are resolved through copies, so they get
+        // neither the penetration translation nor the impulse
+        RigidBody still1, still2;
+        Transform unmoved1, unmoved2;
+        if (m_Components.Get<Collider>(contact.a)->motion != ColliderMotion::DYNAMIC) {
+            still1 = StillCopy(*body1);
+            unmoved1 = *tr1;
+            body1 = &still1;
+            tr1 = &unmoved1;
         }
-        m_Animations.entries[i].applyAnimations(&m_Transforms.GetData(handle), deltaTime);
+        if (m_Components.Get<Collider>(contact.b)->motion != ColliderMotion::DYNAMIC) {
+            still2 = StillCopy(*body2);
+            unmoved2 = *tr2;
+            body2 = &still2;
+            tr2 = &unmoved2;
+        }
+        body1->ResolveCollisions(body2, contact.manifold, t1, t2, *tr1, *tr2, deltaTime);
     }
+}
 
-    // Update Skeletal Animations
-    for (int i = 0; i < m_SkeletalAnimationsManagers.GetSize(); i++) {
-        m_SkeletalAnimationsManagers.entries[i].Update(deltaTime);
+void Engine::UpdateAnimations(float deltaTime) {
+    int animated = m_Components.ParallelEach<Animation, Transform>(m_Jobs.get(),
+        [deltaTime](ObjectHandle, Animation &animation, Transform &transform) {
+            animation.applyAnimations(&transform, deltaTime);
+        });
+    if (animated != m_Components.GetArray<Animation>().GetSize()) {
+        for (auto [handle, animation] : m_Components.View<Animation>()) {
+            if (!m_Components.Has<Transform>(handle))
+                Logger::Error(
+                    "Animation component on object %d requires transform component to work",
+                    handle);
+        }
     }
+}
 
-    // Update RigidBodies
-    for (int i = 0; i < m_RigidBodies.GetSize(); i++) {
-        auto handle = m_RigidBodies.GetFromInternal(i);
-        if (!m_Colliders.HasData(handle) || !m_Transforms.HasData(handle)) {
-            Logger::Error(
-                "RigidBody on object %d must have a collider and a transform to work",
-                handle);
-            continue;
+void Engine::UpdateSkeletalAnimations(float deltaTime) {
+    auto &managers = m_Components.GetArray<SkeletalAnimationsManager>();
+    m_Jobs->ParallelFor(managers.GetSize(), [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            managers.entries[i].Update(deltaTime);
+    });
+}
+
+void Engine::UpdateRigidBodies(float deltaTime) {
+    // Rigid bodies are grouped with colliders and transforms,
+    // so this loop reads all three arrays sequentially
+    int updated = m_Components.ParallelEach<RigidBody, Collider, Transform>(m_Jobs.get(),
+        [deltaTime](ObjectHandle, RigidBody &body, Collider &collider, Transform &transform) {
+            if (collider.motion == ColliderMotion::DYNAMIC)
+                body.Update(&transform, deltaTime);
+        });
+    if (updated != m_Components.GetArray<RigidBody>().GetSize()) {
+        for (auto [handle, body] : m_Components.View<RigidBody>()) {
+            if (!m_Components.Has<Collider>(handle) || !m_Components.Has<Transform>(handle))
+                Logger::Error(
+                    "RigidBody on object %d must have a collider and a transform to work",
+                    handle);
         }
-        m_RigidBodies.GetData(handle).Update(&m_Transforms.GetData(handle), deltaTime);
     }
+}
 
-    // Update sound sources
-    for (int i = 0; i < m_Sounds.GetSize(); i++) {
-        ObjectHandle id = m_Sounds.GetFromInternal(i);
-        auto sound = m_Sounds.GetData(id);
+void Engine::UpdateSounds() {
+    if (!Backend::HasAudio())
+        return;
+    auto &sounds = m_Components.GetArray<Sound>();
+    for (int i = 0; i < sounds.GetSize(); i++) {
+        ObjectHandle id = sounds.GetFromInternal(i);
+        auto &sound = sounds.GetData(id);
         if (sound.GetType() != SoundType::SOUND_3D)
             continue;
 
-        if (!m_Transforms.HasData(id)) {
+        if (!m_Components.Has<Transform>(id)) {
             Logger::Warn("Be careful, 3D sound obj with id %d doesn't have transform", id);
             continue;
         }
@@ -553,9 +876,13 @@ void Engine::updateObjects(float deltaTime) {
         auto transform = GetGlobalTransform(id);
         sound.SetPosition(transform.GetTranslation());
     }
+}
 
-    for (auto behaviour : m_Behaviours) {
-        behaviour->Update(deltaTime);
+void Engine::UpdateBehaviours(float deltaTime) {
+    // Behaviours may spawn objects, so the array can grow while iterating
+    auto &behaviours = m_Components.GetArray<Behaviour *>();
+    for (int i = 0; i < behaviours.GetSize(); i++) {
+        behaviours.entries[i]->Update(deltaTime);
     }
 }
 
@@ -576,118 +903,45 @@ void Engine::Render(int scr_width, int scr_height) {
             static_cast<float>(viewportWidth),
             static_cast<float>(viewportHeight)
         });
-    for (int model_i = 0; model_i < m_Models.GetSize(); model_i++) {
-        ObjectHandle id = m_Models.GetFromInternal(model_i);
-        if (!m_Transforms.HasData(id)) continue;
-
-        auto model = m_Models.GetData(id);
-        auto transform = GetGlobalTransform(id);
-        Mat4 projection = camera->GetProjectionMatrix();
-
-
-        ShaderProgram* shader = model.shader;
-        if (shader == nullptr) {
+    UpdateGlobalTransforms();
+    InterpolateRenderMatrices(m_PhysicsAccumulator / m_PhysicsStep);
+    UploadLights();
+
+    const Mat4 projection = camera->GetProjectionMatrix();
+    const Mat4 view = camera->GetViewMatrix();
+    m_RenderQueue.Clear();
+    m_CullModels.clear();
+    m_CullWorlds.clear();
+    m_CullBoxes.Clear();
+    m_Components.Each<Model, Transform>([&](ObjectHandle id, Model &model, Transform &) {
+        if (model.shader == nullptr) {
             Logger::Warn("No shader connected with Model! Model will not be rendered.");
-            continue;
-        }
-        shader->Use();
-
-        Mat4 view = camera->GetViewMatrix();
-        Vec3 viewPos = camera->GetPosition();
-
-        // send matrix transform to shader
-        shader->SetMat4("model", transform.GetTransformMatrix());
-        shader->SetMat4("view", view);
-        shader->SetVec3("viewPos", viewPos);
-        char str[100];
-        for (int i = 0; i < m_PointLights.GetSize(); i++) {
-            snprintf(str, sizeof(str), "pointLights[%d].position", i);
-            shader->SetVec3(str, m_PointLights.entries[i].position);
-            snprintf(str, sizeof(str), "pointLights[%d].ambient", i);
-            shader->SetVec3(str, m_PointLights.entries[i].ambient);
-            snprintf(str, sizeof(str), "pointLights[%d].diffuse", i);
-            shader->SetVec3(str, m_PointLights.entries[i].diffuse);
-            snprintf(str, sizeof(str), "pointLights[%d].specular", i);
-            shader->SetVec3(str, m_PointLights.entries[i].specular);
-            snprintf(str, sizeof(str), "pointLights[%d].linearDistCoeff", i);
-            shader->SetFloat(str, m_PointLights.entries[i].linearDistCoeff);
-            snprintf(str, sizeof(str), "pointLights[%d].quadraticDistCoeff", i);
-            shader->SetFloat(str, m_PointLights.entries[i].quadraticDistCoeff);
-            snprintf(str, sizeof(str), "pointLights[%d].constDistCoeff", i);
-            shader->SetFloat(str, m_PointLights.entries[i].constDistCoeff);
-        }
-
-        shader->SetInt("lenArrPointL", m_PointLights.GetSize());
-        // directionLight
-        for (int i = 0; i < m_DirLights.GetSize(); i++) {
-            snprintf(str, sizeof(str), "dirLight[%d].ambinet", i);
-            shader->SetVec3(str, m_DirLights.entries[i].ambient);
-            snprintf(str, sizeof(str), "dirLight[%d].specular", i);
-            shader->SetVec3(str, m_DirLights.entries[i].specular);
-            snprintf(str, sizeof(str), "dirLight[%d].direction", i);
-            shader->SetVec3(str, m_DirLights.entries[i].direction);
-            snprintf(str, sizeof(str), "dirLight[%d].diffuse", i);
-            shader->SetVec3(str, m_DirLights.entries[i].diffuse);
-        }
-        shader->SetInt("lenArrDirL", m_DirLights.GetSize());
-        // spotLight
-        for (int i = 0; i < m_SpotLights.GetSize(); i++) {
-            snprintf(str, sizeof(str), "spotLight[%d].diffuse", i);
-            shader->SetVec3(str, m_SpotLights.entries[i].diffuse);
-            snprintf(str, sizeof(str), "spotLight[%d].direction", i);
-            shader->SetVec3(str, camera->GetFront());
-            snprintf(str, sizeof(str), "spotLight[%d].ambient", i);
-            shader->SetVec3(str, m_SpotLights.entries[i].ambient);
-            snprintf(str, sizeof(str), "spotLight[%d].position", i);
-            shader->SetVec3(str, camera->GetPosition());
-            snprintf(str, sizeof(str), "spotLight[%d].specular", i);
-            shader->SetVec3(str, m_SpotLights.entries[i].specular);
-            snprintf(str, sizeof(str), "spotLight[%d].cutOff", i);
-            shader->SetFloat(str, m_SpotLights.entries[i].cutOff);
-            snprintf(str, sizeof(str), "spotLight[%d].linearDistCoeff", i);
-            shader->SetFloat(str, m_SpotLights.entries[i].linearDistCoeff);
-            snprintf(str, sizeof(str), "spotLight[%d].outerCutOff", i);
-            shader->SetFloat(str, m_SpotLights.entries[i].outerCutOff);
-            snprintf(str, sizeof(str), "spotLight[%d].constDistCoeff", i);
-            shader->SetFloat(str, m_SpotLights.entries[i].constDistCoeff);
-            snprintf(str, sizeof(str), "spotLight[%d].quadraticDistCoeff", i);
-            shader->SetFloat(str, m_SpotLights.entries[i].quadraticDistCoeff);
+            return;
         }
-        shader->SetInt("lenArrSpotL", m_SpotLights.GetSize());
-        shader->SetMat4("projection", projection);
-
-
-        for (RenderMesh mesh : model.meshes) {
-            if (m_SkeletalAnimationsManagers.HasData(id)) {
-                auto bones = m_SkeletalAnimationsManagers.GetData(id).GetFinalBoneMatrices();
-                for (int i = 0; i < bones.size(); ++i) {
-                    shader->SetMat4(("finalBonesMatrices[" + std::to_string(i) + "]").c_str(), bones[i]);
-                }
-            }
-
-            shader->SetFloat("material.shininess", mesh.material.shininess);
-            mesh.material.texture.bind();
-
-            if (mesh.material.texture.countComponents() == 0) {
-                shader->SetInt("useTextures", 0);
-                shader->SetVec3("material.diffuseColor", mesh.material.diffuseColor);
-                shader->SetVec3("material.specularColor", mesh.material.specularColor);
-            } else {
-                shader->SetInt("useTextures", 1);
-                shader->SetInt("material.duffuse", 0);
-                shader->SetInt("material.specular", 1);
-            }
-
-            glBindVertexArray(mesh.VAO);
-            glDrawElements(GL_TRIANGLES, mesh.getLenIndices(), GL_UNSIGNED_INT, 0);
+        const Mat4 &world = m_RenderMatrices[m_HandleToHierarchy[GetHandleIndex(id)]];
+        // Bones may move vertices out of model bounds, skinned objects are not culled
+        if (auto manager = m_Components.Get<SkeletalAnimationsManager>(id)) {
+            m_RenderQueue.Push(model.shader, &model.meshes, &world, &manager->GetFinalBoneMatrices());
+            return;
         }
+        m_CullModels.push_back(&model);
+        m_CullWorlds.push_back(&world);
+        m_CullBoxes.Add(model.GetBounds(), world);
+    });
+
+    Frustum frustum = Frustum::FromMatrix(projection * view);
+    m_RenderQueue.CountCulled(frustum.Cull(m_CullBoxes, &m_CullVisible));
+    for (int i = 0; i < m_CullModels.size(); i++) {
+        if (m_CullVisible[i])
+            m_RenderQueue.Push(m_CullModels[i]->shader, &m_CullModels[i]->meshes, m_CullWorlds[i], nullptr);
     }
+    m_RenderQueue.Submit(view, projection, camera->GetPosition());
 
-    for (auto &image : m_Images) {
+    for (auto &image : m_Components.GetArray<Image>()) {
         image.Render();
     }
 
-    for (auto &text : m_Texts) {
+    for (auto &text : m_Components.GetArray<Text>()) {
         text.RenderText();
     }
 
@@ -696,6 +950,47 @@ void Engine::Render(int scr_width, int scr_height) {
 
 
 
+void Engine::UploadLights() {
+    LightsBlock block;
+    auto &pointLights = m_Components.GetArray<PointLight>();
+    block.pointLightCount = std::min(pointLights.GetSize(), MAX_POINT_LIGHTS);
+    for (int i = 0; i < block.pointLightCount; i++) {
+        const PointLight &light = pointLights.entries[i];
+        block.pointLights[i] = PointLightData{
+            light.position, light.constDistCoeff,
+            light.ambient, light.linearDistCoeff,
+            light.diffuse, light.quadraticDistCoeff,
+            light.specular, 0.f};
+    }
+
+    // Spot lights follow the camera
+    auto &spotLights = m_Components.GetArray<SpotLight>();
+    block.spotLightCount = std::min(spotLights.GetSize(), MAX_SPOT_LIGHTS);
+    for (int i = 0; i < block.spotLightCount; i++) {
+        const SpotLight &light = spotLights.entries[i];
+        block.spotLights[i] = SpotLightData{
+            camera->GetPosition(), light.cutOff,
+            camera->GetFront(), light.outerCutOff,
+            light.ambient, light.constDistCoeff,
+            light.diffuse, light.linearDistCoeff,
+            light.specular, light.quadraticDistCoeff};
+    }
+
+    auto &dirLights = m_Components.GetArray<DirLight>();
+    block.dirLightCount = std::min(dirLights.GetSize(), MAX_DIR_LIGHTS);
+    for (int i = 0; i < block.dirLightCount; i++) {
+        const DirLight &light = dirLights.entries[i];
+        block.dirLights[i] = DirLightData{
+            light.direction, 0.f,
+            light.ambient, 0.f,
+            light.diffuse, 0.f,
+            light.specular, 0.f};
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_LightsBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightsBlock), &block);
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 
@@ -0,0 +1,345 @@
+#include "asset_manager.hpp"
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include "backend.hpp"
+#include "font.hpp"
+#include "logger.hpp"
+#include "mapped_file.hpp"
+#include "model.hpp"
+#include "shaders.hpp"
+#include "texture.hpp"
+
+AssetManager::Cache<std::string, const aiScene> AssetManager::s_Scenes;
+AssetManager::Cache<std::string, const Model> AssetManager::s_Models;
+AssetManager::Cache<std::string, const TextureAsset> AssetManager::s_Textures;
+AssetManager::Cache<std::string, const TextureAsset> AssetManager::s_Images;
+AssetManager::Cache<std::pair<std::string, std::string>, ShaderProgram> AssetManager::s_ShaderPrograms;
+AssetManager::Cache<std::pair<std::string, unsigned int>, Font> AssetManager::s_Fonts;
+std::mutex AssetManager::s_Mutex;
+std::map<std::string, AssetFuture<const Model>> AssetManager::s_PendingModels;
+std::map<std::string, AssetFuture<const TextureAsset>> AssetManager::s_PendingTextures;
+std::mutex AssetManager::s_UploadMutex;
+std::deque<std::function<void()>> AssetManager::s_Uploads;
+// Defined last, so it is destroyed first and loads in flight finish while caches still exist
+std::unique_ptr<JobSystem> AssetManager::s_Loader;
+
+// Returns cached asset or stores the one created by `load`. Failed loads are not cached.
+// Load runs unlocked, if another thread stores the asset meanwhile its copy is returned
+template<typename Key, typename T, typename F>
+std::shared_ptr<T> AssetManager::FindOrLoad(Cache<Key, T> *cache, const Key &key, F load) {
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        auto it = cache->find(key);
+        if (it != cache->end())
+            return it->second;
+    }
+    std::shared_ptr<T> asset = load();
+    if (!asset)
+        return nullptr;
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    return cache->emplace(key, std::move(asset)).first->second;
+}
+
+template<typename T>
+static AssetFuture<T> MakeReady(std::shared_ptr<T> asset) {
+    std::promise<std::shared_ptr<T>> promise;
+    promise.set_value(std::move(asset));
+    return promise.get_future().share();
+}
+
+template<typename Key, typename T, typename F>
+static void EraseIf(std::map<Key, std::shared_ptr<T>> *cache, F predicate) {
+    for (auto it = cache->begin(); it != cache->end();) {
+        if (predicate(*it))
+            it = cache->erase(it);
+        else
+            it++;
+    }
+}
+
+std::shared_ptr<const aiScene> AssetManager::LoadScene(const std::string &path) {
+    std::string finalPath = GetResourcePath(Resource::MODEL, path);
+    return FindOrLoad(&s_Scenes, finalPath, [&]() -> std::shared_ptr<const aiScene> {
+        auto importer = std::make_shared<Assimp::Importer>();
+        const aiScene *scene = importer->ReadFile(finalPath, aiProcess_Triangulate | aiProcess_FlipUVs);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+            Logger::Error("ERROR::ASSIMP::%s", importer->GetErrorString());
+            return nullptr;
+        }
+        // Scene is owned by the importer, so the pointer keeps the importer alive
+        return std::shared_ptr<const aiScene>(importer, scene);
+    });
+}
+
+// Baked model of the file, nullptr if there is none or it is older than the file
+static std::shared_ptr<const MappedFile> OpenBakedModel(const std::string &finalPath) {
+    namespace fs = std::filesystem;
+    std::string bakedPath = finalPath + BAKED_MODEL_EXTENSION;
+    std::error_code error;
+    auto bakedTime = fs::last_write_time(bakedPath, error);
+    if (error)
+        return nullptr;
+    auto sourceTime = fs::last_write_time(finalPath, error);
+    if (!error && sourceTime > bakedTime) {
+        Logger::Warn("ASSET_MANAGER::BAKED_MODEL_OUTDATED %s", bakedPath.c_str());
+        return nullptr;
+    }
+    return MappedFile::Open(bakedPath);
+}
+
+std::shared_ptr<const Model> AssetManager::LoadModel(const std::string &path) {
+    std::string finalPath = GetResourcePath(Resource::MODEL, path);
+    return FindOrLoad(&s_Models, finalPath, [&]() -> std::shared_ptr<const Model> {
+        if (auto baked = OpenBakedModel(finalPath)) {
+            if (Model *model = Model::fromBakedFile(std::move(baked)))
+                return std::shared_ptr<const Model>(model);
+            Logger::Warn("ASSET_MANAGER::BAKED_MODEL_INVALID %s%s", finalPath.c_str(), BAKED_MODEL_EXTENSION);
+        }
+        auto scene = LoadScene(path);
+        if (!scene)
+            return nullptr;
+        return std::shared_ptr<const Model>(Model::fromScene(scene.get()));
+    });
+}
+
+AssetFuture<const Model> AssetManager::LoadModelAsync(const std::string &path) {
+    std::string finalPath = GetResourcePath(Resource::MODEL, path);
+    auto promise = std::make_shared<std::promise<std::shared_ptr<const Model>>>();
+    AssetFuture<const Model> future;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        auto cached = s_Models.find(finalPath);
+        if (cached != s_Models.end())
+            return MakeReady(cached->second);
+        auto pending = s_PendingModels.find(finalPath);
+        if (pending != s_PendingModels.end())
+            return pending->second;
+        future = promise->get_future().share();
+        s_PendingModels.emplace(finalPath, future);
+    }
+
+    RunInBackground([path, finalPath, promise]() {
+        // Either the mapped baked model or data imported from the file
+        auto baked = OpenBakedModel(finalPath);
+        BakedModelView view;
+        if (baked && !ReadBakedModel(baked->GetData(), baked->GetSize(), &view))
+            baked = nullptr;
+        auto data = std::make_shared<ModelData>();
+        std::set<std::string> textures;
+        if (baked) {
+            baked->Prefetch();
+            for (uint32_t i = 0; i < view.header->meshCount; i++) {
+                textures.insert(view.GetString(view.meshes[i].diffuseTexture));
+                textures.insert(view.GetString(view.meshes[i].specularTexture));
+            }
+        } else if (auto scene = LoadScene(path)) {
+            *data = Model::importScene(scene.get());
+            for (auto &mesh : data->meshes) {
+                textures.insert(mesh.diffuseTexture);
+                textures.insert(mesh.specularTexture);
+            }
+        } else {
+            data = nullptr;
+        }
+
+        // Decoded textures are uploaded first, so the model finds them in the cache
+        std::vector<std::pair<std::string, DecodedImage>> images;
+        textures.erase("");
+        for (auto &texture : textures) {
+            std::string texturePath = GetResourcePath(Resource::TEXTURE, texture);
+            bool cached;
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                cached = s_Textures.count(texturePath) > 0;
+            }
+            if (!cached && Backend::HasGraphics())
+                images.emplace_back(texturePath, DecodedImage::Decode(texturePath));
+        }
+
+        QueueUpload([finalPath, promise, baked, data, images]() {
+            for (auto &[texturePath, image] : images)
+                FindOrLoad(&s_Textures, texturePath, [&]() { return TextureAsset::FromDecoded(image); });
+            std::shared_ptr<const Model> model;
+            if (baked || data) {
+                model = FindOrLoad(&s_Models, finalPath, [&]() {
+                    Model *loaded = baked ? Model::fromBakedFile(baked) : Model::fromData(std::move(*data));
+                    return std::shared_ptr<const Model>(loaded);
+                });
+            }
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                s_PendingModels.erase(finalPath);
+            }
+            promise->set_value(std::move(model));
+        });
+    });
+    return future;
+}
+
+AssetFuture<const TextureAsset> AssetManager::LoadTextureAsync(const std::string &path) {
+    if (!Backend::HasGraphics())
+        return MakeReady<const TextureAsset>(nullptr);
+    std::string finalPath = GetResourcePath(Resource::TEXTURE, path);
+    auto promise = std::make_shared<std::promise<std::shared_ptr<const TextureAsset>>>();
+    AssetFuture<const TextureAsset> future;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        auto cached = s_Textures.find(finalPath);
+        if (cached != s_Textures.end())
+            return MakeReady(cached->second);
+        auto pending = s_PendingTextures.find(finalPath);
+        if (pending != s_PendingTextures.end())
+            return pending->second;
+        future = promise->get_future().share();
+        s_PendingTextures.emplace(finalPath, future);
+    }
+
+    RunInBackground([finalPath, promise]() {
+        DecodedImage image = DecodedImage::Decode(finalPath);
+        if (!image.pixels)
+            Logger::Error("TEXTURE::LOADER::PROGRAM::FILE_NOT_FOUND_FAILED: %s", finalPath.c_str());
+        QueueUpload([finalPath, promise, image]() {
+            auto texture = FindOrLoad(&s_Textures, finalPath, [&]() {
+                return TextureAsset::FromDecoded(image);
+            });
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                s_PendingTextures.erase(finalPath);
+            }
+            promise->set_value(std::move(texture));
+        });
+    });
+    return future;
+}
+
+int AssetManager::ProcessUploads(double budget) {
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(s_UploadMutex);
+            if (s_Uploads.empty())
+                return 0;
+            upload = std::move(s_Uploads.front());
+            s_Uploads.pop_front();
+        }
+        upload();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budget) {
+            std::lock_guard<std::mutex> lock(s_UploadMutex);
+            return static_cast<int>(s_Uploads.size());
+        }
+    }
+}
+
+void AssetManager::RunInBackground(std::function<void()> task) {
+    JobSystem *loader;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        if (!s_Loader)
+            s_Loader = std::make_unique<JobSystem>(ASSET_LOADER_THREADS);
+        loader = s_Loader.get();
+    }
+    auto run = [](void *data, int, int) {
+        std::unique_ptr<std::function<void()>> task(static_cast<std::function<void()> *>(data));
+        (*task)();
+    };
+    loader->Run(nullptr, run, new std::function<void()>(std::move(task)));
+}
+
+void AssetManager::QueueUpload(std::function<void()> upload) {
+    std::lock_guard<std::mutex> lock(s_UploadMutex);
+    s_Uploads.push_back(std::move(upload));
+}
+
+bool AssetManager::BakeModel(const std::string &path) {
+    auto scene = LoadScene(path);
+    if (!scene)
+        return false;
+    std::string bakedPath = GetResourcePath(Resource::MODEL, path) + BAKED_MODEL_EXTENSION;
+    return WriteBakedModel(Model::importScene(scene.get()), bakedPath);
+}
+
+std::shared_ptr<const TextureAsset> AssetManager::LoadTexture(const std::string &path) {
+    if (!Backend::HasGraphics())
+        return nullptr;
+    std::string finalPath = GetResourcePath(Resource::TEXTURE, path);
+    return FindOrLoad(&s_Textures, finalPath, [&]() { return TextureAsset::FromFile(finalPath); });
+}
+
+std::shared_ptr<const TextureAsset> AssetManager::LoadImage(const std::string &path) {
+    if (!Backend::HasGraphics())
+        return nullptr;
+    std::string finalPath = GetResourcePath(Resource::IMAGE, path);
+    return FindOrLoad(&s_Images, finalPath, [&]() { return TextureAsset::FromImageFile(finalPath); });
+}
+
+std::shared_ptr<ShaderProgram> AssetManager::LoadShaderProgram(const std::string &vertexPath,
+                                                               const std::string &fragmentPath) {
+    auto key = std::make_pair(GetResourcePath(Resource::VSHADER, vertexPath),
+                              GetResourcePath(Resource::FSHADER, fragmentPath));
+    return FindOrLoad(&s_ShaderPrograms, key, [&]() {
+        return std::make_shared<ShaderProgram>(Shader(VertexShader, vertexPath),
+                                               Shader(FragmentShader, fragmentPath));
+    });
+}
+
+std::shared_ptr<Font> AssetManager::LoadFont(const std::string &path, unsigned int size) {
+    auto key = std::make_pair(GetResourcePath(Resource::FONT, path), size);
+    return FindOrLoad(&s_Fonts, key, [&]() { return std::make_shared<Font>(path, size); });
+}
+
+void AssetManager::Unload(Resource resource, const std::string &path) {
+    std::string finalPath = GetResourcePath(resource, path);
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    switch (resource) {
+    case Resource::MODEL:
+        s_Scenes.erase(finalPath);
+        s_Models.erase(finalPath);
+        break;
+    case Resource::TEXTURE:
+        s_Textures.erase(finalPath);
+        break;
+    case Resource::IMAGE:
+        s_Images.erase(finalPath);
+        break;
+    case Resource::VSHADER:
+    case Resource::FSHADER:
+        EraseIf(&s_ShaderPrograms, [&](const auto &entry) {
+            return entry.first.first == finalPath || entry.first.second == finalPath;
+        });
+        break;
+    case Resource::FONT:
+        EraseIf(&s_Fonts, [&](const auto &entry) { return entry.first.first == finalPath; });
+        break;
+    default:
+        Logger::Warn("ASSET_MANAGER::UNLOAD::UNSUPPORTED_RESOURCE %s", finalPath.c_str());
+    }
+}
+
+void AssetManager::UnloadUnused() {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    auto unused = [](const auto &entry) { return entry.second.use_count() == 1; };
+    // Models first, they hold textures
+    EraseIf(&s_Models, unused);
+    EraseIf(&s_Scenes, unused);
+    EraseIf(&s_Textures, unused);
+    EraseIf(&s_Images, unused);
+    EraseIf(&s_ShaderPrograms, unused);
+    EraseIf(&s_Fonts, unused);
+}
+
+void AssetManager::UnloadAll() {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Models.clear();
+    s_Scenes.clear();
+    s_Textures.clear();
+    s_Images.clear();
+    s_ShaderPrograms.clear();
+    s_Fonts.clear();
+}
@@ -0,0 +1,15 @@
+#include "backend.hpp"
+
+bool Backend::s_Headless = false;
+
+bool Backend::HasGraphics() {
+    return !s_Headless;
+}
+
+bool Backend::HasAudio() {
+    return !s_Headless;
+}
+
+void Backend::SetHeadless(bool headless) {
+    s_Headless = headless;
+}
@@ -0,0 +1,84 @@
+#include "frustum.hpp"
+#include <cmath>
+
+void BoxArray::Clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+void BoxArray::Add(const AABB &local, const Mat4 &matrix) {
+    AABB bounds = local.TransformedBounds(matrix);
+    Vec3 center = (bounds.min + bounds.max) * 0.5f;
+    Vec3 extent = (bounds.max - bounds.min) * 0.5f;
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    extentX.push_back(extent.x);
+    extentY.push_back(extent.y);
+    extentZ.push_back(extent.z);
+}
+
+int BoxArray::GetSize() const {
+    return static_cast<int>(centerX.size());
+}
+
+Frustum Frustum::FromMatrix(const Mat4 &viewProjection) {
+    // Clip space point is inside when -w <= x, y, z <= w, so every plane is
+    // the last row plus or minus one of the others (Gribb and Hartmann)
+    auto row = [&](int i) {
+        return Vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+    const Vec4 planes[6] = {
+        row(3) + row(0), row(3) - row(0),
+        row(3) + row(1), row(3) - row(1),
+        row(3) + row(2), row(3) - row(2),
+    };
+    Frustum frustum;
+    for (int i = 0; i < 6; i++) {
+        frustum.normalX[i] = planes[i].x;
+        frustum.normalY[i] = planes[i].y;
+        frustum.normalZ[i] = planes[i].z;
+        frustum.offset[i] = planes[i].w;
+    }
+    return frustum;
+}
+
+bool Frustum::Intersects(const AABB &box) const {
+    Vec3 center = (box.min + box.max) * 0.5f;
+    Vec3 extent = (box.max - box.min) * 0.5f;
+    for (int i = 0; i < 6; i++) {
+        float distance = normalX[i] * center.x + normalY[i] * center.y + normalZ[i] * center.z + offset[i];
+        float radius = std::abs(normalX[i]) * extent.x + std::abs(normalY[i]) * extent.y
+            + std::abs(normalZ[i]) * extent.z;
+        if (distance + radius < 0.f)
+            return false;
+    }
+    return true;
+}
+
+int Frustum::Cull(const BoxArray &boxes, std::vector<uint8_t> *visible) const {
+    const int count = boxes.GetSize();
+    visible->assign(count, 1);
+    uint8_t *result = visible->data();
+    const float *cx = boxes.centerX.data(), *cy = boxes.centerY.data(), *cz = boxes.centerZ.data();
+    const float *ex = boxes.extentX.data(), *ey = boxes.extentY.data(), *ez = boxes.extentZ.data();
+    // One plane at a time over all boxes, the inner loop has no branches
+    for (int plane = 0; plane < 6; plane++) {
+        const float nx = normalX[plane], ny = normalY[plane], nz = normalZ[plane], d = offset[plane];
+        const float ax = std::abs(nx), ay = std::abs(ny), az = std::abs(nz);
+        for (int i = 0; i < count; i++) {
+            float distance = nx * cx[i] + ny * cy[i] + nz * cz[i] + d;
+            float radius = ax * ex[i] + ay * ey[i] + az * ez[i];
+            result[i] &= static_cast<uint8_t>(distance + radius >= 0.f);
+        }
+    }
+
+    int culled = 0;
+    for (int i = 0; i < count; i++)
+        culled += result[i] == 0;
+    return culled;
+}
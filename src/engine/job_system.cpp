@@ -0,0 +1,133 @@
+#include "job_system.hpp"
+
+// Worker threads remember their queue, owner of the pool is checked as
+// threads of several pools may exist at once
+static thread_local const JobSystem *t_Owner = nullptr;
+static thread_local int t_QueueIndex = 0;
+
+JobSystem::JobSystem(int workerCount) {
+    if (workerCount < 0)
+        workerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+
+    for (int i = 0; i <= workerCount; i++) {
+        m_Queues.push_back(std::make_unique<Queue>());
+        m_Queues.back()->jobs.resize(JOB_QUEUE_CAPACITY);
+    }
+    for (int i = 0; i < workerCount; i++)
+        m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Quit = true;
+    }
+    m_WakeUp.notify_all();
+    for (auto &worker : m_Workers)
+        worker.join();
+}
+
+int JobSystem::GetWorkerCount() const {
+    return static_cast<int>(m_Workers.size());
+}
+
+void JobSystem::Run(Counter *counter, Function function, void *data, int begin, int end) {
+    Job job{function, data, begin, end, counter};
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    if (m_Workers.empty()) {
+        Execute(job);
+        return;
+    }
+
+    m_Queued.fetch_add(1, std::memory_order_release);
+    if (!Push(m_Queues[GetQueueIndex()].get(), job)) {
+        // Queue is full
+        m_Queued.fetch_sub(1, std::memory_order_relaxed);
+        Execute(job);
+        return;
+    }
+    {
+        // Sleeping worker checks m_Queued under the lock, so the wake up is not lost
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+    }
+    m_WakeUp.notify_one();
+}
+
+bool JobSystem::RunPending() {
+    if (m_Queued.load(std::memory_order_acquire) == 0)
+        return false;
+
+    Job job;
+    int own = GetQueueIndex();
+    bool found = PopBack(m_Queues[own].get(), &job);
+    for (int i = 1; !found && i < m_Queues.size(); i++)
+        found = PopFront(m_Queues[(own + i) % m_Queues.size()].get(), &job);
+    if (!found)
+        return false;
+
+    m_Queued.fetch_sub(1, std::memory_order_relaxed);
+    Execute(job);
+    return true;
+}
+
+void JobSystem::Wait(Counter *counter) {
+    while (counter->pending.load(std::memory_order_acquire) > 0) {
+        if (!RunPending())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::Execute(const Job &job) {
+    job.function(job.data, job.begin, job.end);
+    if (job.counter)
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+bool JobSystem::Push(Queue *queue, const Job &job) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    int capacity = static_cast<int>(queue->jobs.size());
+    if (queue->size == capacity)
+        return false;
+    queue->jobs[(queue->head + queue->size) % capacity] = job;
+    queue->size++;
+    return true;
+}
+
+bool JobSystem::PopBack(Queue *queue, Job *job) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->size == 0)
+        return false;
+    queue->size--;
+    *job = queue->jobs[(queue->head + queue->size) % queue->jobs.size()];
+    return true;
+}
+
+bool JobSystem::PopFront(Queue *queue, Job *job) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->size == 0)
+        return false;
+    *job = queue->jobs[queue->head];
+    queue->head = (queue->head + 1) % queue->jobs.size();
+    queue->size--;
+    return true;
+}
+
+int JobSystem::GetQueueIndex() const {
+    return t_Owner == this ? t_QueueIndex : 0;
+}
+
+void JobSystem::WorkerLoop(int queueIndex) {
+    t_Owner = this;
+    t_QueueIndex = queueIndex;
+    while (true) {
+        if (RunPending())
+            continue;
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_WakeUp.wait(lock, [this] {
+            return m_Quit || m_Queued.load(std::memory_order_acquire) > 0;
+        });
+        if (m_Quit)
+            return;
+    }
+}
@@ -0,0 +1,87 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "logger.hpp"
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string &path) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return nullptr;
+    }
+    // View keeps the file open, handles are not needed after mapping
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping)
+        return nullptr;
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        Logger::Error("MAPPED_FILE::MAP_FAILED %s", path.c_str());
+        return nullptr;
+    }
+    file->m_Size = static_cast<size_t>(size.QuadPart);
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor == -1)
+        return nullptr;
+    struct stat info;
+    if (fstat(descriptor, &info) == -1 || info.st_size == 0) {
+        close(descriptor);
+        return nullptr;
+    }
+    // Mapping keeps the file open, descriptor is not needed after mapping
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (data == MAP_FAILED) {
+        Logger::Error("MAPPED_FILE::MAP_FAILED %s", path.c_str());
+        return nullptr;
+    }
+    file->m_Size = static_cast<size_t>(info.st_size);
+#endif
+    file->m_Data = static_cast<const unsigned char *>(data);
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (!m_Data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+#else
+    munmap(const_cast<unsigned char *>(m_Data), m_Size);
+#endif
+}
+
+const unsigned char *MappedFile::GetData() const {
+    return m_Data;
+}
+
+size_t MappedFile::GetSize() const {
+    return m_Size;
+}
+
+void MappedFile::Prefetch() const {
+    // One read per page is enough to fault it in
+    const size_t pageSize = 4096;
+    unsigned char sum = 0;
+    for (size_t offset = 0; offset < m_Size; offset += pageSize)
+        sum += m_Data[offset];
+    volatile unsigned char sink = sum;
+    (void)sink;
+}
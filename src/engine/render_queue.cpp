@@ -0,0 +1,208 @@
+#include "render_queue.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+
+RenderQueue::~RenderQueue() {
+    if (m_InstanceBuffer != 0)
+        glDeleteBuffers(1, &m_InstanceBuffer);
+}
+
+void RenderQueue::Clear() {
+    m_Items.clear();
+    m_Objects = 0;
+    m_Stats = RenderStats{};
+}
+
+void RenderQueue::CountCulled(int objects) {
+    m_Stats.culledObjects += objects;
+}
+
+void RenderQueue::Push(ShaderProgram *shader, std::vector<RenderMesh> *meshes, const Mat4 *world,
+                       const std::vector<Mat4> *bones) {
+    int object = m_Objects++;
+    for (RenderMesh &mesh : *meshes)
+        m_Items.push_back(DrawItem{GetKey(shader, &mesh, object), shader, &mesh, world, bones});
+}
+
+void RenderQueue::Submit(const Mat4 &view, const Mat4 &projection, Vec3 viewPos) {
+    std::sort(m_Items.begin(), m_Items.end(), [](const DrawItem &a, const DrawItem &b) {
+        return a.key < b.key;
+    });
+
+    m_Stats.items = static_cast<int>(m_Items.size());
+    BuildBatches();
+
+    // Other code binds textures between frames, so nothing is known to be bound
+    std::fill(std::begin(m_BoundTextures), std::end(m_BoundTextures), ~0u);
+    // and uniforms of any program may have been changed
+    m_ProgramMaterials.clear();
+    ShaderProgram *program = nullptr;
+    const Mat4 *world = nullptr;
+    unsigned int vertexArray = ~0u;
+
+    for (const Batch &batch : m_Batches) {
+        const DrawItem &item = m_Items[batch.begin];
+        // Copies of ShaderProgram share the GL program and its uniforms
+        ShaderProgram *shader = item.shader;
+        if (!program || shader->GetId() != program->GetId()) {
+            program = shader;
+            world = nullptr;
+            shader->Use();
+            shader->SetMat4("view", view);
+            shader->SetMat4("projection", projection);
+            shader->SetVec3("viewPos", viewPos);
+            m_Stats.programChanges++;
+        }
+
+        if (batch.instanceOffset == -1 && item.world != world) {
+            world = item.world;
+            shader->SetMat4("model", *world);
+            int bones = item.bones ? std::min(static_cast<int>(item.bones->size()), MAX_BONES) : 0;
+            if (bones > 0)
+                shader->SetMat4Array("finalBonesMatrices", item.bones->data(), bones);
+        }
+
+        SetMaterial(shader, &item.mesh->material);
+
+        if (item.mesh->getVAO() != vertexArray) {
+            vertexArray = item.mesh->getVAO();
+            glBindVertexArray(vertexArray);
+            m_Stats.vertexArrayChanges++;
+        }
+
+        if (batch.instanceOffset == -1) {
+            glDrawElements(GL_TRIANGLES, item.mesh->getLenIndices(), GL_UNSIGNED_INT, 0);
+        } else {
+            // Instance attributes are part of the vertex array state, so they
+            // are pointed at the batch every time
+            glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+            for (int column = 0; column < 4; column++) {
+                int location = INSTANCE_MATRIX_LOCATION + column;
+                size_t offset = batch.instanceOffset * sizeof(Mat4) + column * sizeof(Vec4);
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Mat4),
+                                      reinterpret_cast<void*>(offset));
+                glVertexAttribDivisor(location, 1);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDrawElementsInstanced(GL_TRIANGLES, item.mesh->getLenIndices(), GL_UNSIGNED_INT, 0,
+                                    batch.end - batch.begin);
+            m_Stats.instancedDrawCalls++;
+        }
+        m_Stats.drawCalls++;
+    }
+}
+
+const RenderStats &RenderQueue::GetStats() const {
+    return m_Stats;
+}
+
+uint64_t RenderQueue::GetKey(ShaderProgram *shader, RenderMesh *mesh, int object) {
+    Texture &texture = mesh->material.texture;
+    uint64_t program = shader->GetId() & 0xFFFF;
+    uint64_t firstTexture = texture.countComponents() > 0 ? texture.textureId(0) & 0xFFFF : 0;
+    uint64_t vertexArray = mesh->getVAO() & 0xFFFF;
+    // Instanced items have no per-object uniforms, so they are grouped by material instead
+    uint64_t last = shader->IsInstanced() ? MaterialHash(mesh->material) : object;
+    return program << 48 | firstTexture << 32 | vertexArray << 16 | (last & 0xFFFF);
+}
+
+uint64_t RenderQueue::MaterialHash(const Material &material) {
+    const float values[] = {
+        material.shininess,
+        material.diffuseColor.x, material.diffuseColor.y, material.diffuseColor.z,
+        material.specularColor.x, material.specularColor.y, material.specularColor.z,
+    };
+    // FNV-1a over the bytes
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(values);
+    for (size_t i = 0; i < sizeof(values); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash ^ hash >> 16 ^ hash >> 32 ^ hash >> 48;
+}
+
+bool RenderQueue::SameMaterial(const Material &a, const Material &b) {
+    if (a.shininess != b.shininess || a.texture.countComponents() != b.texture.countComponents())
+        return false;
+    for (int i = 0; i < a.texture.countComponents(); i++) {
+        if (a.texture.textureId(i) != b.texture.textureId(i))
+            return false;
+    }
+    // Colors are not used when the material has textures
+    return a.texture.countComponents() > 0 ||
+        (a.diffuseColor == b.diffuseColor && a.specularColor == b.specularColor);
+}
+
+bool RenderQueue::CanInstance(const DrawItem &first, const DrawItem &item) {
+    if (item.shader->GetId() != first.shader->GetId() || item.mesh->getVAO() != first.mesh->getVAO())
+        return false;
+    return SameMaterial(first.mesh->material, item.mesh->material);
+}
+
+void RenderQueue::BuildBatches() {
+    m_Batches.clear();
+    m_InstanceMatrices.clear();
+    int size = static_cast<int>(m_Items.size());
+    for (int begin = 0, end; begin < size; begin = end) {
+        end = begin + 1;
+        if (!m_Items[begin].shader->IsInstanced()) {
+            m_Batches.push_back(Batch{begin, end, -1});
+            continue;
+        }
+        while (end < size && CanInstance(m_Items[begin], m_Items[end]))
+            end++;
+        m_Batches.push_back(Batch{begin, end, static_cast<int>(m_InstanceMatrices.size())});
+        for (int i = begin; i < end; i++)
+            m_InstanceMatrices.push_back(*m_Items[i].world);
+    }
+    if (m_InstanceMatrices.empty())
+        return;
+
+    if (m_InstanceBuffer == 0)
+        glGenBuffers(1, &m_InstanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+    // Buffer is respecified every frame, so the driver does not wait for the previous one
+    glBufferData(GL_ARRAY_BUFFER, m_InstanceMatrices.size() * sizeof(Mat4), m_InstanceMatrices.data(),
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RenderQueue::BindTextures(Texture *texture) {
+    for (int i = 0; i < texture->countComponents(); i++) {
+        unsigned int id = texture->textureId(i);
+        if (m_BoundTextures[i] == id)
+            continue;
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, id);
+        m_BoundTextures[i] = id;
+        m_Stats.textureChanges++;
+    }
+}
+
+void RenderQueue::SetMaterial(ShaderProgram *shader, Material *material) {
+    // Textures are shared by every program, so they are bound even if uniforms are set
+    if (material->texture.countComponents() > 0)
+        BindTextures(&material->texture);
+
+    auto last = std::find_if(m_ProgramMaterials.begin(), m_ProgramMaterials.end(),
+        [shader](const auto &entry) { return entry.first == shader->GetId(); });
+    if (last == m_ProgramMaterials.end()) {
+        m_ProgramMaterials.emplace_back(shader->GetId(), material);
+    } else {
+        if (last->second == material || SameMaterial(*last->second, *material))
+            return;
+        last->second = material;
+    }
+    m_Stats.materialChanges++;
+
+    shader->SetFloat("material.shininess", material->shininess);
+    if (material->texture.countComponents() == 0) {
+        shader->SetInt("useTextures", 0);
+        shader->SetVec3("material.diffuseColor", material->diffuseColor);
+        shader->SetVec3("material.specularColor", material->specularColor);
+    } else {
+        shader->SetInt("useTextures", 1);
+        shader->SetInt("material.diffuse", 0);
+        shader->SetInt("material.specular", 1);
+    }
+}
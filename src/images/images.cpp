@@ -6,36 +6,23 @@
 #include <glm/glm.hpp>
 #include "images.hpp"
 #include "path_resolver.hpp"
-#include "stb_image.h"
 #include "user_config.hpp"
+#include "backend.hpp"
+#include "asset_manager.hpp"
 
 Image::Image(std::string path, float relX, float relY, float scale) {
-  path = GetResourcePath(Resource::IMAGE, path);
   m_Visible = true;
   m_RelX = relX;
   m_RelY = relY;
   m_Scale = scale;
-
-  int nrComponents;
-  unsigned char *data = reinterpret_cast<unsigned char*>(
-    stbi_load(path.c_str(), &m_Width, &m_Height, &nrComponents, 0));
-
-  if (!data) {
-      stbi_image_free(data);
-      Logger::Error("IMAGE::LOADER::FILE_NOT_FOUND_FAILED: %s", path.c_str());
+  if (!Backend::HasGraphics())
       return;
-  }
-
-  glGenTextures(1, &m_TextureID);
-  glBindTexture(GL_TEXTURE_2D, m_TextureID);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
-  stbi_image_free(data);
+  m_Texture = AssetManager::LoadImage(path);
+  if (!m_Texture)
+      return;
+  m_Width = m_Texture->width;
+  m_Height = m_Texture->height;
 
   glGenVertexArrays(1, &m_VAO);
   glGenBuffers(1, &m_VBO);
@@ -47,23 +34,21 @@ Image::Image(std::string path, float relX, float relY, float scale) {
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
-  Shader vShader = Shader(VertexShader, "text.vshader");
-  Shader fShader = Shader(FragmentShader, "image.fshader");
-  m_ShaderProgram = ShaderProgram(vShader, fShader);
+  m_ShaderProgram = AssetManager::LoadShaderProgram("text.vshader", "image.fshader");
 }
 
 void Image::Render() {
-  if (!m_Visible) return;
+  if (!m_Visible || !m_Texture) return;
 
   glDisable(GL_DEPTH_TEST);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  m_ShaderProgram.Use();
+  m_ShaderProgram->Use();
   glm::mat4 projection =
       glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
-  m_ShaderProgram.SetMat4("projection", projection);
-  m_ShaderProgram.SetVec3("textColor", Vec3(1));
+  m_ShaderProgram->SetMat4("projection", projection);
+  m_ShaderProgram->SetVec3("textColor", Vec3(1));
 
   glActiveTexture(GL_TEXTURE0);
   glBindVertexArray(m_VAO);
@@ -83,7 +68,7 @@ void Image::Render() {
     { xpos + w, ypos + h,   1.0f, 0.0f }
   };
 
-  glBindTexture(GL_TEXTURE_2D, m_TextureID);
+  glBindTexture(GL_TEXTURE_2D, m_Texture->id);
   glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
@@ -3,6 +3,7 @@
 #include <stdarg.h>
 #include <ctime>
 #include <chrono>
+#include <mutex>
 
 FILE* Logger::s_LoggingFile = stdout;
 LogLevel Logger::s_LogLevel = LogLevel::INFO;
@@ -32,6 +33,9 @@ void Logger::SetLoggingLevel(LogLevel level) {
 }
 
 void Logger::Log(const char* logLevel, const char *format, va_list args) {
+    // Messages come from job threads too, keep their lines whole
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
     char buffer[32];
     GetTime(buffer, sizeof(buffer));
     fprintf(Logger::s_LoggingFile, "%s | %s | ", buffer, logLevel);
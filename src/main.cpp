@@ -12,7 +12,7 @@ const char *cubeSource = "cube2.obj";
 const char *catSource = "fish.obj";
 const char *benchSource = "bench.obj";
 
-const char *standartVertexShaderSource = "standart.vshader";
+const char *standartVertexShaderSource = "standart_instanced.vshader";
 const char *skeletalVertexShaderSource = "skeletal.vshader";
 const char *fragmentShaderSource = "standart.fshader";
 
@@ -213,6 +213,7 @@ int main() {
         Vec3(0, 0, 0),
         0,
         Vec3(0));
+    staticAABB.GetCollider()->motion = ColliderMotion::STATIC;
 
 
     auto getSphereObj = [=, &engine](Transform transform, Vec3 speed, float mass) {
@@ -238,7 +239,7 @@ int main() {
     };
 
     {
-        auto ocraFont = new Font("OCRAEXT.TTF", 20);
+        auto ocraFont = AssetManager::LoadFont("OCRAEXT.TTF", 20).get();
         auto obj = engine->NewObject();
         obj.AddText(ocraFont, "", 0.85f, 0.95f, 1.f, Vec3(0, 0, 0));
         auto obj2 = engine->NewObject();
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "asset_manager.hpp"
+#include "backend.hpp"
+#include "logger.hpp"
+
+// Bakes model files given as paths relative to resources/models,
+// every model file found there if none is given.
+// Run from the directory containing resources, as the engine does
+int main(int argc, char **argv) {
+    namespace fs = std::filesystem;
+    Backend::SetHeadless(true);
+
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty()) {
+        const fs::path root = GetResourcePath(Resource::MODEL, "");
+        const std::vector<std::string> extensions = {".obj", ".gltf", ".glb", ".fbx", ".dae"};
+        std::error_code error;
+        for (auto &entry : fs::recursive_directory_iterator(root, error)) {
+            std::string extension = entry.path().extension().string();
+            if (entry.is_regular_file() &&
+                std::find(extensions.begin(), extensions.end(), extension) != extensions.end())
+                paths.push_back(entry.path().lexically_relative(root).generic_string());
+        }
+    }
+
+    int failed = 0;
+    for (auto &path : paths) {
+        if (AssetManager::BakeModel(path)) {
+            Logger::Info("Baked %s", path.c_str());
+        } else {
+            Logger::Error("BAKE::FAILED %s", path.c_str());
+            failed++;
+        }
+        AssetManager::UnloadAll();
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "broadphase.hpp"
+#include "collisions.hpp"
+#include "job_system.hpp"
+#include "narrowphase.hpp"
+
+// Random rotation matrix
+static Mat3 RandomRotation(std::mt19937 &random) {
+    std::normal_distribution<float> normal;
+    std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+    Vec3 axis = glm::normalize(Vec3(normal(random), normal(random), normal(random)));
+    return Mat3(glm::rotate(Mat4(1.f), angle(random), axis));
+}
+
+// Measures pairs per second of box narrowphase tests. Boxes are packed
+// densely enough for about half of the pairs to collide.
+// Then measures narrowphase of broadphase pairs in a scene of spheres and
+// AABBs tested one by one and by Narrowphase, and how many pairs are left
+// when most of the colliders are static
+int main(int argc, char **argv) {
+    const int pairCount = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> coordinate(-2.f, 2.f);
+    std::uniform_real_distribution<float> size(0.5f, 1.5f);
+
+    std::vector<OBB> obbs;
+    std::vector<AABB> aabbs;
+    for (int i = 0; i < 2 * pairCount; i++) {
+        Vec3 center(coordinate(random), coordinate(random), coordinate(random));
+        Vec3 half(size(random), size(random), size(random));
+        obbs.push_back(OBB{center, RandomRotation(random), half});
+        aabbs.push_back(AABB{center - half, center + half});
+    }
+
+    // `test(i)` tests i-th pair and returns whether it collides
+    auto measure = [&](const char *name, auto test) {
+        auto start = std::chrono::steady_clock::now();
+        int hits = 0;
+        for (int i = 0; i < pairCount; i++)
+            hits += test(i);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-20s %12.0f pairs/s  %d hits\n", name, pairCount / seconds, hits);
+    };
+
+    measure("OBB-OBB", [&](int i) {
+        return CollidePrimitive(obbs[2 * i], obbs[2 * i + 1]).collide;
+    });
+    measure("AABB-OBB", [&](int i) {
+        return CollidePrimitive(aabbs[2 * i], obbs[2 * i + 1]).collide;
+    });
+
+    PackedArray<Collider> colliders;
+    std::vector<Transform> transforms;
+    SweepAndPrune broadphase;
+    std::uniform_real_distribution<float> position(-40.f, 40.f);
+    for (int i = 0; i < pairCount / 10; i++) {
+        Vec3 translation(position(random), position(random), position(random));
+        transforms.push_back(Transform(translation, Vec3(size(random)), 0.f, Vec3(0.f, 1.f, 0.f)));
+        if (i % 2)
+            colliders.SetData(i, Collider{Sphere{Vec3(0.f), 1.f}});
+        else
+            colliders.SetData(i, Collider{AABB{Vec3(-1.f), Vec3(1.f)}});
+        broadphase.Update(i, colliders.GetData(i).GetBounds(transforms[i]));
+    }
+    std::vector<BroadphasePair> pairs;
+    broadphase.FindPairs(&pairs);
+    std::vector<CollisionManifold> manifolds;
+
+    // `collide` fills `manifolds` for every pair
+    auto measurePairs = [&](const char *name, auto collide) {
+        const int repeats = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+            collide();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int hits = 0;
+        for (auto &manifold : manifolds)
+            hits += manifold.collide;
+        std::printf("%-20s %12.0f pairs/s  %d hits\n", name, pairs.size() * repeats / seconds, hits);
+    };
+
+    std::printf("%zu pairs of spheres and AABBs\n", pairs.size());
+    measurePairs("Collider::Collide", [&] {
+        manifolds.resize(pairs.size());
+        for (int i = 0; i < pairs.size(); i++) {
+            manifolds[i] = colliders.GetData(pairs[i].a).Collide(transforms[pairs[i].a],
+                    &colliders.GetData(pairs[i].b), transforms[pairs[i].b]);
+        }
+    });
+    Narrowphase narrowphase;
+    for (int workers : {0, -1}) {
+        JobSystem jobs(workers);
+        measurePairs(workers ? "Narrowphase, jobs" : "Narrowphase", [&] {
+            narrowphase.Collide(pairs, &colliders, transforms, &jobs, &manifolds);
+        });
+    }
+
+    // Level geometry: nine of ten colliders are static
+    for (int i = 0; i < colliders.GetSize(); i++) {
+        if (i % 10)
+            colliders.GetData(i).motion = ColliderMotion::STATIC;
+    }
+    std::vector<BroadphasePair> filtered;
+    for (auto &pair : pairs) {
+        if (Collider::CanCollide(colliders.GetData(pair.a), colliders.GetData(pair.b)))
+            filtered.push_back(pair);
+    }
+    std::printf("%zu of them with a dynamic collider\n", filtered.size());
+    pairs = filtered;
+    JobSystem jobs(0);
+    measurePairs("Narrowphase", [&] {
+        narrowphase.Collide(pairs, &colliders, transforms, &jobs, &manifolds);
+    });
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "animation.hpp"
+#include "collider.hpp"
+#include "component_registry.hpp"
+#include "rigid_body.hpp"
+#include "transform.hpp"
+
+using Registry = ComponentRegistry<TypeList<Transform, Collider, RigidBody, Animation>>;
+
+// Measures joins of component arrays as the engine loops do them: looking
+// every component up by handle, range-for over View and Each. Rigid bodies
+// are then grouped with colliders and transforms and measured again.
+// Components are added in shuffled order, so arrays are not sorted alike.
+// Uses the registry as it is now, not as it was when views were added
+int main() {
+    const int objectCount = 1000;
+    const float dt = 1e-4f;
+    auto registry = std::make_unique<Registry>();
+    std::mt19937 random(3);
+    std::vector<ObjectHandle> order(objectCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    // `add(handle)` adds a component to an object
+    auto addShuffled = [&](auto add) {
+        std::shuffle(order.begin(), order.end(), random);
+        for (ObjectHandle handle : order)
+            add(handle);
+    };
+    addShuffled([&](ObjectHandle handle) { registry->Add<Transform>(handle); });
+    addShuffled([&](ObjectHandle handle) {
+        if (handle % 10 < 7)
+            registry->Add<Collider>(handle, Collider{Sphere{Vec3(0.f), 1.f}});
+    });
+    addShuffled([&](ObjectHandle handle) {
+        if (handle % 10 < 8)
+            registry->Add<RigidBody>(handle, RigidBody(1.f, Mat3(1.f), 0.5f, Vec3(0.f, -1.f, 0.f), 0.1f));
+    });
+    addShuffled([&](ObjectHandle handle) {
+        if (handle % 10 >= 7)
+            registry->Add<Animation>(handle);
+    });
+
+    auto &bodies = registry->GetArray<RigidBody>();
+    auto &colliders = registry->GetArray<Collider>();
+    auto &transforms = registry->GetArray<Transform>();
+    auto &animations = registry->GetArray<Animation>();
+
+    // Microseconds per call of `loop`
+    auto measure = [](const char *name, int repeats, auto loop) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+            loop();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-32s %8.2f us\n", name, seconds * 1e6 / repeats);
+    };
+
+    volatile float sink = 0.f;
+    auto runJoins = [&](const char *suffix) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "join lookup%s", suffix);
+        measure(name, 100000, [&] {
+            float sum = 0.f;
+            for (int i = 0; i < animations.GetSize(); i++) {
+                ObjectHandle handle = animations.GetFromInternal(i);
+                if (transforms.HasData(handle))
+                    sum += transforms.GetData(handle).GetScale().x;
+            }
+            sink = sum;
+        });
+        std::snprintf(name, sizeof(name), "join View%s", suffix);
+        measure(name, 100000, [&] {
+            float sum = 0.f;
+            for (auto [handle, animation, transform] : registry->View<Animation, Transform>())
+                sum += transform.GetScale().x;
+            sink = sum;
+        });
+        std::snprintf(name, sizeof(name), "join Each%s", suffix);
+        measure(name, 100000, [&] {
+            float sum = 0.f;
+            registry->Each<Animation, Transform>([&sum](ObjectHandle, Animation &, Transform &transform) {
+                sum += transform.GetScale().x;
+            });
+            sink = sum;
+        });
+
+        std::snprintf(name, sizeof(name), "rigid bodies lookup%s", suffix);
+        measure(name, 20000, [&] {
+            for (int i = 0; i < bodies.GetSize(); i++) {
+                ObjectHandle handle = bodies.GetFromInternal(i);
+                if (!colliders.HasData(handle) || !transforms.HasData(handle))
+                    continue;
+                bodies.entries[i].Update(&transforms.GetData(handle), dt);
+            }
+        });
+        std::snprintf(name, sizeof(name), "rigid bodies Each%s", suffix);
+        measure(name, 20000, [&] {
+            registry->Each<RigidBody, Collider, Transform>(
+                [dt](ObjectHandle, RigidBody &body, Collider &, Transform &transform) {
+                    body.Update(&transform, dt);
+                });
+        });
+
+        std::snprintf(name, sizeof(name), "animations lookup%s", suffix);
+        measure(name, 20000, [&] {
+            for (int i = 0; i < animations.GetSize(); i++) {
+                ObjectHandle handle = animations.GetFromInternal(i);
+                if (transforms.HasData(handle))
+                    animations.entries[i].applyAnimations(&transforms.GetData(handle), dt);
+            }
+        });
+        std::snprintf(name, sizeof(name), "animations Each%s", suffix);
+        measure(name, 20000, [&] {
+            registry->Each<Animation, Transform>(
+                [dt](ObjectHandle, Animation &animation, Transform &transform) {
+                    animation.applyAnimations(&transform, dt);
+                });
+        });
+    };
+
+    runJoins("");
+    registry->Group<RigidBody, Collider, Transform>();
+    runJoins(", grouped");
+    return 0;
+}
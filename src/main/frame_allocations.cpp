@@ -0,0 +1,65 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "engine.hpp"
+#include "object.hpp"
+#include "rigid_body.hpp"
+
+// Every allocation of the process goes through these, so the counter
+// sees allocations made by the engine and by worker threads alike
+static std::atomic<long> s_Allocations{0};
+
+void *operator new(size_t size) {
+    s_Allocations++;
+    if (void *pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+// Steps a headless scene of falling and colliding rigid bodies and checks
+// that a frame past warm-up makes no heap allocations. Buffers reach their
+// final size during warm-up and are reused afterwards.
+// Only Engine::Step is covered: Render needs a window and a GL context,
+// which headless mode doesn't have, so draw code is not checked here.
+// Exits with non-zero code if any frame allocated
+int main() {
+    Engine engine(EngineMode::HEADLESS);
+    engine.SetWorkerCount(3);
+    for (int i = 0; i < 300; i++) {
+        Object object = engine.NewObject();
+        object.AddTransform(Vec3(i % 20 * 1.5f, i / 20 * 1.5f, 0.f), Vec3(1.f), Mat4(1.f));
+        if (i % 3 == 0)
+            object.AddCollider(Sphere{Vec3(0.f), 1.f});
+        else if (i % 3 == 1)
+            object.AddCollider(AABB{Vec3(-1.f), Vec3(1.f)});
+        else
+            object.AddCollider(OBB{Vec3(0.f), Mat3(1.f), Vec3(1.f)});
+        object.AddRigidBody(RigidBody(1.f, IBodySphere(1.f, 1.f), 0.5f, Vec3(0.f, -9.8f, 0.f), 0.1f));
+    }
+    Object floor = engine.NewObject();
+    floor.AddTransform(Vec3(15.f, -5.f, 0.f), Vec3(100.f, 1.f, 100.f), Mat4(1.f));
+    floor.AddCollider(AABB{Vec3(-0.5f), Vec3(0.5f)}).motion = ColliderMotion::STATIC;
+
+    const float deltaTime = 1.f / 60.f;
+    for (int i = 0; i < 60; i++)
+        engine.Step(deltaTime);
+
+    const int frames = 300;
+    long before = s_Allocations;
+    for (int i = 0; i < frames; i++)
+        engine.Step(deltaTime);
+    long allocations = s_Allocations - before;
+
+    std::printf("%ld heap allocations in %d frames\n", allocations, frames);
+    return allocations > 0 ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "backend.hpp"
+#include "collisions.hpp"
+#include "engine.hpp"
+#include "object.hpp"
+
+// Height field of size x size quads spanning [-1, 1] on x and z
+static Mesh *MakeTerrain(int size) {
+    std::vector<Vertex> points;
+    std::vector<unsigned int> indices;
+    for (int x = 0; x <= size; x++) {
+        for (int z = 0; z <= size; z++) {
+            Vertex vertex{};
+            float u = 2.f * x / size - 1.f, v = 2.f * z / size - 1.f;
+            vertex.Position = Vec3(u, 0.1f * std::sin(8.f * u) * std::cos(8.f * v), v);
+            points.push_back(vertex);
+        }
+    }
+    for (int x = 0; x < size; x++) {
+        for (int z = 0; z < size; z++) {
+            unsigned int a = x * (size + 1) + z, b = a + 1, c = a + size + 1, d = c + 1;
+            indices.insert(indices.end(), {a, b, c, b, d, c});
+        }
+    }
+    return new Mesh(points, indices);
+}
+
+// Measures rays per second of GlobalRaycast in a scene of spheres, boxes
+// and mesh colliders with both broadphases, against testing every collider
+// as it used to be done. Also measures raycasts into a single big mesh
+int main(int argc, char **argv) {
+    const int objectCount = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const int rayCount = 20000;
+    Backend::SetHeadless(true);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> coordinate(-100.f, 100.f);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::unique_ptr<Mesh> sphereMesh(Mesh::GetSphere());
+
+    std::vector<Ray> rays;
+    for (int i = 0; i < rayCount; i++) {
+        Vec3 from(coordinate(random), coordinate(random), coordinate(random));
+        rays.push_back(Ray(from, from + Vec3(unit(random), unit(random), unit(random))));
+    }
+
+    // `cast` returns number of rays that hit, `fraction` tells how many of them it cast
+    auto measure = [&](const char *name, auto cast, int fraction = 1) {
+        auto start = std::chrono::steady_clock::now();
+        int hits = cast();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-28s %12.0f rays/s  %d hits\n", name, rayCount / fraction / seconds, hits);
+    };
+
+    for (int grid = 0; grid < 2; grid++) {
+        // Both broadphases get the same scene
+        std::mt19937 sceneRandom(2);
+        Engine engine(EngineMode::HEADLESS);
+        if (grid)
+            engine.SetBroadphase(std::make_unique<UniformGrid>(8.f));
+        for (int i = 0; i < objectCount; i++) {
+            Object object = engine.NewObject();
+            Vec3 position(coordinate(sceneRandom), coordinate(sceneRandom), coordinate(sceneRandom));
+            object.AddTransform(position, Vec3(1.f), Mat4(1.f));
+            if (i % 3 == 0)
+                object.AddCollider(Sphere{Vec3(0.f), 1.f});
+            else if (i % 3 == 1)
+                object.AddCollider(AABB{Vec3(-1.f), Vec3(1.f)});
+            else
+                object.AddCollider(sphereMesh.get());
+        }
+        engine.SyncColliders();
+        std::printf("%d colliders, %s\n", objectCount, grid ? "uniform grid" : "sweep and prune");
+
+        if (!grid) {
+            measure("every collider", [&] {
+                int hits = 0;
+                for (auto &ray : rays) {
+                    float best = 1e18f;
+                    engine.Each<Collider, Transform>(
+                        [&](ObjectHandle, Collider &collider, Transform &transform) {
+                            auto hit = collider.RaycastHit(transform, ray);
+                            if (hit && *hit < best)
+                                best = *hit;
+                        });
+                    hits += best < 1e18f;
+                }
+                return hits;
+            });
+        }
+        measure("GlobalRaycast", [&] {
+            int hits = 0;
+            for (auto &ray : rays)
+                hits += engine.GlobalRaycast(ray).has_value();
+            return hits;
+        });
+        measure("GlobalRaycast batch", [&] {
+            std::vector<std::optional<ObjectHandle>> results;
+            engine.GlobalRaycast(rays, &results);
+            int hits = 0;
+            for (auto &result : results)
+                hits += result.has_value();
+            return hits;
+        });
+    }
+
+    std::unique_ptr<Mesh> terrain(MakeTerrain(200));
+    Transform transform(Vec3(0.f), Vec3(100.f, 20.f, 100.f), 0.3f, Vec3(0.f, 1.f, 0.f));
+    std::printf("mesh of %d triangles\n", terrain->getLenIndices() / 3);
+    measure("every triangle", [&] {
+        int hits = 0;
+        Mat4 matrix = transform.GetTransformMatrix();
+        // A hundredth of the rays is enough, testing every triangle is slow
+        for (int i = 0; i < rayCount / 100; i++) {
+            bool hit = false;
+            for (int j = 0; j < terrain->getLenIndices() / 3; j++)
+                hit |= CollisionPrimitive(rays[i], terrain->GetTriangle(j, matrix)).has_value();
+            hits += hit;
+        }
+        return hits;
+    }, 100);
+    measure("CollisionMeshAt", [&] {
+        int hits = 0;
+        for (auto &ray : rays)
+            hits += CollisionMeshAt(ray, terrain.get(), transform).has_value();
+        return hits;
+    });
+    return 0;
+}
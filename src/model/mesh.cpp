@@ -54,10 +54,12 @@ int Mesh::getLenArrPoints() {
 /* Setters */
 void Mesh::setPoints(const std::vector<Vertex>& points) {
     this->points.assign(points.begin(), points.end());
+    UpdateBVH();
 }
 
 void Mesh::setIndices(const std::vector<unsigned int>& indices) {
     this->indices.assign(indices.begin(), indices.end());
+    UpdateBVH();
 }
 
 void Mesh::setDefaultIndices() {
@@ -65,52 +67,67 @@ void Mesh::setDefaultIndices() {
     for (unsigned int i = 0; i < points.size(); i++) {
         indices[i] = i;
     }
+    UpdateBVH();
 }
 
+void Mesh::UpdateBVH() {
+    // Indices may still refer to old points while both are being replaced
+    for (unsigned int index : indices) {
+        if (index >= points.size()) {
+            bvh.Clear();
+            return;
+        }
+    }
+    bvh.Build(points.data(), indices.data(), getLenIndices());
+}
 
-/* Utils  */
-Vec3 Mesh::ClosestPoint(Vec3 point, Transform transform) {
-    Mat4 modelMat = transform.GetTransformMatrix();
+const MeshBVH &Mesh::GetBVH() const {
+    return bvh;
+}
 
-    auto loadPos = [=](int i) {
-        int id = getIndices()[i];
-        Vec4 res = Vec4 {getPoints()[id].Position, 1.0} * modelMat;
-        return Vec3{ res.x / res.w, res.y / res.w, res.z / res.w };
+Triangle Mesh::GetTriangle(int index, const Mat4 &matrix) const {
+    auto load = [&](int i) {
+        return Vec3(matrix * Vec4(points[indices[3 * index + i]].Position, 1.f));
     };
+    return Triangle(load(0), load(1), load(2));
+}
 
+/* Utils  */
+// Finds the triangle closest to `point`. Node bounds are moved to world space
+// rather than the point to local space, as scale does not preserve distances
+static int ClosestTriangle(const Mesh &mesh, Vec3 point, const Mat4 &modelMat, Vec3 *closest) {
+    int res = -1;
+    float min = std::numeric_limits<float>::max();
+    mesh.GetBVH().Nearest(
+        [&](const AABB &bounds) {
+            return bounds.TransformedBounds(modelMat).Distance2(point);
+        },
+        [&](int triangle) {
+            Vec3 p = mesh.GetTriangle(triangle, modelMat).ClosestPoint(point);
+            float dist = glm::dot(p - point, p - point);
+            if (dist < min) {
+                min = dist;
+                res = triangle;
+                *closest = p;
+            }
+            return dist;
+        });
+    return res;
+}
+
+Vec3 Mesh::ClosestPoint(Vec3 point, Transform transform) {
     Vec3 res = Vec3(std::numeric_limits<float>::max());
-    for (int i = 0; i < getLenIndices(); i += 3) {
-        Triangle tri = Triangle(loadPos(i), loadPos(i + 1), loadPos(i + 2));
-        Vec3 p = tri.ClosestPoint(point);
-        if (glm::length(p) < glm::length(res))
-            res = p;
-    }
+    ClosestTriangle(*this, point, transform.GetTransformMatrix(), &res);
     return res;
 }
 
 Vec3 Mesh::CollisionNormal(Vec3 point, Transform transform) {
-    const int stride = 8;
     Mat4 modelMat = transform.GetTransformMatrix();
-
-    auto loadPos = [=](int i) {
-        int id = getIndices()[i];
-        Vec4 res = Vec4 {getPoints()[id].Position, 1.0} * modelMat;
-        return Vec3{ res.x / res.w, res.y / res.w, res.z / res.w };
-    };
-
-    float min = std::numeric_limits<float>::max();
-
-    Triangle *res;
-    for (int i = 0; i < getLenIndices(); i += 3) {
-        Triangle tri = Triangle(loadPos(i), loadPos(i + 1), loadPos(i + 2));
-        float dist = tri.Distance2(point);
-        if (dist < min) {
-            min = dist;
-            *res = tri;
-        }
-    }
-
-    return -Norm((*res).normal);
+    Vec3 closest;
+    int triangle = ClosestTriangle(*this, point, modelMat, &closest);
+    if (triangle == -1)
+        return Vec3(0.f);
+    return -Norm(GetTriangle(triangle, modelMat).normal);
     // Is ok direction or i should make smthg with this ?
 }
 
@@ -4,44 +4,111 @@
 #include <assimp/postprocess.h>
 #include <vector>
 #include <string>
+#include <utility>
 
 #include "path_resolver.hpp"
 #include "pretty_print.hpp"
+#include "asset_manager.hpp"
 
 Model* Model::loadFromFile(std::string path) {
+    auto model = AssetManager::LoadModel(path);
+    if (!model)
+        return nullptr;
+    return new Model(*model);
+}
+
+Model* Model::fromScene(const aiScene *scene) {
+    return fromData(importScene(scene));
+}
+
+Model* Model::fromData(ModelData data) {
     Model* newModel = new Model();
-    std::string finalPath = GetResourcePath(Resource::MODEL, path);
-    Assimp::Importer import;
-    const aiScene *scene = import.ReadFile(finalPath, aiProcess_Triangulate | aiProcess_FlipUVs);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        Logger::Error("ERROR::ASSIMP::%s", import.GetErrorString());
-        return 0;
+    newModel->meshes.reserve(data.meshes.size());
+    bool skinned = data.skeleton.boneCounter > 0;
+    for (auto &mesh : data.meshes) {
+        Material material = makeMaterial(mesh.shininess, mesh.diffuseColor, mesh.specularColor,
+                                         mesh.diffuseTexture, mesh.specularTexture);
+        newModel->meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), material, skinned);
     }
-    newModel->processNode(scene->mRootNode, scene);
+    *newModel->m_Skeleton = std::move(data.skeleton);
+    newModel->UpdateBounds();
     return newModel;
 }
 
+Model* Model::fromBakedFile(std::shared_ptr<const MappedFile> file) {
+    const unsigned char *data = file->GetData();
+    BakedModelView view;
+    if (!ReadBakedModel(data, file->GetSize(), &view))
+        return nullptr;
+
+    Model* newModel = new Model();
+    newModel->meshes.reserve(view.header->meshCount);
+    bool skinned = view.header->boneCounter > 0;
+    for (uint32_t i = 0; i < view.header->meshCount; i++) {
+        const BakedMesh &mesh = view.meshes[i];
+        Material material = makeMaterial(mesh.shininess, glm::make_vec3(mesh.diffuseColor),
+                                         glm::make_vec3(mesh.specularColor),
+                                         view.GetString(mesh.diffuseTexture),
+                                         view.GetString(mesh.specularTexture));
+        auto points = reinterpret_cast<const Vertex *>(data + mesh.verticesOffset);
+        auto indices = reinterpret_cast<const unsigned int *>(data + mesh.indicesOffset);
+        auto asset = std::make_shared<const MeshAsset>(file, ArrayView<Vertex>(points, mesh.vertexCount),
+                                                       ArrayView<unsigned int>(indices, mesh.indexCount),
+                                                       skinned);
+        newModel->meshes.emplace_back(std::move(asset), material);
+    }
+    for (uint32_t i = 0; i < view.header->boneCount; i++) {
+        newModel->m_Skeleton->boneInfoMap[view.GetString(view.bones[i].name)] =
+            BoneInfo{view.bones[i].id, glm::make_mat4(view.bones[i].offset)};
+    }
+    newModel->m_Skeleton->boneCounter = view.header->boneCounter;
+    newModel->UpdateBounds();
+    return newModel;
+}
+
+ModelData Model::importScene(const aiScene *scene) {
+    ModelData data;
+    processNode(scene->mRootNode, scene, &data);
+    return data;
+}
+
+Material Model::makeMaterial(float shininess, Vec3 diffuseColor, Vec3 specularColor,
+                             const std::string &diffuseTexture, const std::string &specularTexture) {
+    Texture t;
+    if (!diffuseTexture.empty()) {
+        t = Texture(diffuseTexture);
+        if (!specularTexture.empty())
+            t.loadImage(specularTexture);
+    }
+    return Material{shininess, t, diffuseColor, specularColor};
+}
+
 Model* Model::loadFromFile(std::string path, ShaderProgram *shader) {
     Model* newModel = loadFromFile(path);
-    newModel->shader = shader;
+    if (newModel)
+        newModel->shader = shader;
     return newModel;
 }
 
-void Model::processNode(aiNode *node, const aiScene *scene) {
+void Model::processNode(aiNode *node, const aiScene *scene, ModelData *data) {
     // process all the node's meshes (if any)
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        data->meshes.push_back(processMesh(mesh, scene, &data->skeleton));
     }
     // then do the same for each of its children
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, data);
     }
 }
 
-RenderMesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+MeshData Model::processMesh(aiMesh *mesh, const aiScene *scene, ModelSkeleton *skeleton) {
+    MeshData data;
+    std::vector<Vertex> &vertices = data.vertices;
+    std::vector<unsigned int> &indices = data.indices;
+    vertices.reserve(mesh->mNumVertices);
+    // Scene is triangulated
+    indices.reserve(mesh->mNumFaces * 3);
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         // process vertex positions, normals and texture coordinates
@@ -63,35 +130,31 @@ RenderMesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
         for (unsigned int j = 0; j < face.mNumIndices; j++)
             indices.push_back(face.mIndices[j]);
     }
-    Texture t;
-    Vec3 diffuseColor, specularColor;
-
-    float shininess = 1.0f;
     if (mesh->mMaterialIndex >= 0) {
         aiMaterial *mat = scene->mMaterials[mesh->mMaterialIndex];
 
         aiColor3D color(0.f);
         mat->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-        diffuseColor = Vec3(color.r, color.g, color.b);
+        data.diffuseColor = Vec3(color.r, color.g, color.b);
         mat->Get(AI_MATKEY_COLOR_SPECULAR, color);
-        specularColor = Vec3(color.r, color.g, color.b);
+        data.specularColor = Vec3(color.r, color.g, color.b);
 
         if (mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
             aiString s;
             mat->GetTexture(aiTextureType_DIFFUSE, 0, &s);
-            t = Texture(std::string(s.C_Str()));
+            data.diffuseTexture = s.C_Str();
 
             if (mat->GetTextureCount(aiTextureType_SPECULAR) > 0) {
                 aiString s;
                 mat->GetTexture(aiTextureType_SPECULAR, 0, &s);
-                t.loadImage(std::string(s.C_Str()));
+                data.specularTexture = s.C_Str();
             }
         }
-        mat->Get(AI_MATKEY_SHININESS, shininess);
+        mat->Get(AI_MATKEY_SHININESS, data.shininess);
     }
 
-    ExtractBoneWeightForVertices(vertices, mesh, scene);
-    return RenderMesh(vertices, indices, Material{shininess, t, diffuseColor, specularColor});
+    ExtractBoneWeightForVertices(vertices, mesh, skeleton);
+    return data;
 }
 
 void Model::setMaterial(Material material) {
@@ -100,39 +163,60 @@ void Model::setMaterial(Material material) {
     }
 }
 
+const AABB &Model::GetBounds() {
+    if (!m_HasBounds)
+        UpdateBounds();
+    return m_Bounds;
+}
+
+void Model::UpdateBounds() {
+    m_HasBounds = true;
+    bool empty = true;
+    for (auto &mesh : meshes) {
+        for (auto &vertex : mesh.getVecPoints()) {
+            m_Bounds.min = empty ? vertex.Position : glm::min(m_Bounds.min, vertex.Position);
+            m_Bounds.max = empty ? vertex.Position : glm::max(m_Bounds.max, vertex.Position);
+            empty = false;
+        }
+    }
+    if (empty)
+        m_Bounds = AABB{Vec3(0.f), Vec3(0.f)};
+}
+
 Model *Model::fromMesh(Mesh *mesh, Material material) {
     Model *newModel = new Model();
-    std::vector<RenderMesh> meshes;
-    meshes.push_back(*(new RenderMesh(mesh, material)));
-    newModel->meshes = meshes;
+    newModel->meshes.emplace_back(mesh, material);
+    newModel->UpdateBounds();
     return newModel;
 }
 
 Model *Model::fromMesh(Mesh *mesh, Material material, ShaderProgram *shader) {
     Model *newModel = new Model();
-    std::vector<RenderMesh> meshes;
-    meshes.push_back(*(new RenderMesh(mesh, material)));
-    newModel->meshes = meshes;
+    newModel->meshes.emplace_back(mesh, material);
     newModel->shader = shader;
+    newModel->UpdateBounds();
     return newModel;
 }
 
 
-void Model::ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh* mesh, const aiScene* scene) {
+void Model::ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh* mesh,
+                                         ModelSkeleton *skeleton) {
+    auto &boneInfoMap = skeleton->boneInfoMap;
+    int &boneCounter = skeleton->boneCounter;
     for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex) {
         int boneID = -1;
         std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
-        if (m_BoneInfoMap.find(boneName) == m_BoneInfoMap.end()) {
+        if (boneInfoMap.find(boneName) == boneInfoMap.end()) {
             BoneInfo newBoneInfo;
-            newBoneInfo.id = m_BoneCounter;
-            assert(m_BoneCounter < MAX_BONES);
+            newBoneInfo.id = boneCounter;
+            assert(boneCounter < MAX_BONES);
             newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(
                 mesh->mBones[boneIndex]->mOffsetMatrix);
-            m_BoneInfoMap[boneName] = newBoneInfo;
-            boneID = m_BoneCounter;
-            m_BoneCounter++;
+            boneInfoMap[boneName] = newBoneInfo;
+            boneID = boneCounter;
+            boneCounter++;
         } else {
-            boneID = m_BoneInfoMap[boneName].id;
+            boneID = boneInfoMap[boneName].id;
         }
         assert(boneID != -1);
         auto weights = mesh->mBones[boneIndex]->mWeights;
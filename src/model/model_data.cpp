@@ -0,0 +1,147 @@
+#include "model_data.hpp"
+
+#include <cstring>
+#include <fstream>
+#include "engine_config.hpp"
+#include "logger.hpp"
+
+#define BAKED_MODEL_ALIGNMENT 16
+
+template<typename T>
+static uint64_t Append(std::vector<unsigned char> *buffer, const T *data, size_t count) {
+    uint64_t offset = buffer->size();
+    buffer->resize(offset + sizeof(T) * count);
+    if (count > 0)
+        std::memcpy(buffer->data() + offset, data, sizeof(T) * count);
+    return offset;
+}
+
+static void Align(std::vector<unsigned char> *buffer) {
+    size_t size = buffer->size() + BAKED_MODEL_ALIGNMENT - 1;
+    buffer->resize(size - size % BAKED_MODEL_ALIGNMENT);
+}
+
+static BakedString AddString(std::string *strings, const std::string &value) {
+    BakedString result{static_cast<uint32_t>(strings->size()), static_cast<uint32_t>(value.size())};
+    strings->append(value);
+    return result;
+}
+
+bool WriteBakedModel(const ModelData &model, const std::string &path) {
+    std::string strings;
+    BakedModelHeader header{};
+    header.magic = BAKED_MODEL_MAGIC;
+    header.version = BAKED_MODEL_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.meshCount = static_cast<uint32_t>(model.meshes.size());
+    header.boneCount = static_cast<uint32_t>(model.skeleton.boneInfoMap.size());
+    header.boneCounter = model.skeleton.boneCounter;
+
+    std::vector<BakedMesh> meshes(model.meshes.size());
+    std::vector<BakedBone> bones;
+    for (auto &[name, info] : model.skeleton.boneInfoMap) {
+        BakedBone bone{};
+        bone.name = AddString(&strings, name);
+        bone.id = info.id;
+        std::memcpy(bone.offset, &info.offset[0][0], sizeof(bone.offset));
+        bones.push_back(bone);
+    }
+
+    // Tables are written once offsets are known
+    std::vector<unsigned char> buffer;
+    Append(&buffer, &header, 1);
+    uint64_t meshesOffset = Append(&buffer, meshes.data(), meshes.size());
+    Append(&buffer, bones.data(), bones.size());
+    for (size_t i = 0; i < model.meshes.size(); i++) {
+        const MeshData &source = model.meshes[i];
+        BakedMesh &mesh = meshes[i];
+        Align(&buffer);
+        mesh.verticesOffset = Append(&buffer, source.vertices.data(), source.vertices.size());
+        Align(&buffer);
+        mesh.indicesOffset = Append(&buffer, source.indices.data(), source.indices.size());
+        mesh.vertexCount = static_cast<uint32_t>(source.vertices.size());
+        mesh.indexCount = static_cast<uint32_t>(source.indices.size());
+        mesh.shininess = source.shininess;
+        for (int j = 0; j < 3; j++) {
+            mesh.diffuseColor[j] = source.diffuseColor[j];
+            mesh.specularColor[j] = source.specularColor[j];
+        }
+        mesh.diffuseTexture = AddString(&strings, source.diffuseTexture);
+        mesh.specularTexture = AddString(&strings, source.specularTexture);
+    }
+    header.stringsOffset = Append(&buffer, strings.data(), strings.size());
+    header.stringsSize = strings.size();
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    if (!meshes.empty())
+        std::memcpy(buffer.data() + meshesOffset, meshes.data(), sizeof(BakedMesh) * meshes.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    if (!file) {
+        Logger::Error("BAKED_MODEL::WRITE_FAILED %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Array of `count` elements of `size` bytes at `offset` is inside the file
+static bool InBounds(uint64_t offset, uint64_t count, uint64_t size, size_t fileSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / size;
+}
+
+static bool InBounds(BakedString string, const BakedModelHeader &header) {
+    return string.offset <= header.stringsSize && string.length <= header.stringsSize - string.offset;
+}
+
+// Indices address vertices of the mesh and bone ids fit the bone palette.
+// Negative bone ids mark unused influences
+static bool ValidContents(const unsigned char *data, const BakedMesh &mesh) {
+    auto vertices = reinterpret_cast<const Vertex *>(data + mesh.verticesOffset);
+    auto indices = reinterpret_cast<const unsigned int *>(data + mesh.indicesOffset);
+    for (uint32_t i = 0; i < mesh.indexCount; i++) {
+        if (indices[i] >= mesh.vertexCount)
+            return false;
+    }
+    for (uint32_t i = 0; i < mesh.vertexCount; i++) {
+        for (int j = 0; j < MAX_BONE_INFLUENCE; j++) {
+            if (vertices[i].m_BoneIDs[j] >= MAX_BONES)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool ReadBakedModel(const unsigned char *data, size_t size, BakedModelView *view) {
+    if (size < sizeof(BakedModelHeader))
+        return false;
+    auto header = reinterpret_cast<const BakedModelHeader *>(data);
+    if (header->magic != BAKED_MODEL_MAGIC || header->version != BAKED_MODEL_VERSION ||
+        header->vertexSize != sizeof(Vertex))
+        return false;
+
+    uint64_t meshesOffset = sizeof(BakedModelHeader);
+    uint64_t bonesOffset = meshesOffset + sizeof(BakedMesh) * uint64_t(header->meshCount);
+    if (!InBounds(meshesOffset, header->meshCount, sizeof(BakedMesh), size) ||
+        !InBounds(bonesOffset, header->boneCount, sizeof(BakedBone), size) ||
+        !InBounds(header->stringsOffset, header->stringsSize, 1, size))
+        return false;
+
+    auto meshes = reinterpret_cast<const BakedMesh *>(data + meshesOffset);
+    for (uint32_t i = 0; i < header->meshCount; i++) {
+        const BakedMesh &mesh = meshes[i];
+        if (mesh.verticesOffset % alignof(Vertex) != 0 || mesh.indicesOffset % alignof(unsigned int) != 0 ||
+            !InBounds(mesh.verticesOffset, mesh.vertexCount, sizeof(Vertex), size) ||
+            !InBounds(mesh.indicesOffset, mesh.indexCount, sizeof(unsigned int), size) ||
+            !InBounds(mesh.diffuseTexture, *header) || !InBounds(mesh.specularTexture, *header) ||
+            !ValidContents(data, mesh))
+            return false;
+    }
+    auto bones = reinterpret_cast<const BakedBone *>(data + bonesOffset);
+    for (uint32_t i = 0; i < header->boneCount; i++) {
+        if (!InBounds(bones[i].name, *header) || bones[i].id >= MAX_BONES)
+            return false;
+    }
+    auto strings = reinterpret_cast<const char *>(data + header->stringsOffset);
+    *view = BakedModelView{header, meshes, bones, strings};
+    return true;
+}
@@ -0,0 +1,148 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+#include "vertex_layout.hpp"
+#include "engine_config.hpp"
+
+static_assert(MAX_BONES <= 256, "Compact vertex layouts store bone ids in 8 bits");
+
+const VertexLayout &VertexLayout::Full() {
+    static const VertexLayout layout{sizeof(Vertex), {
+        {0, VertexElement::Position, VertexFormat::Float3, offsetof(Vertex, Position)},
+        {1, VertexElement::Normal, VertexFormat::Float3, offsetof(Vertex, Normal)},
+        {2, VertexElement::TexCoords, VertexFormat::Float2, offsetof(Vertex, TexCoords)},
+        {3, VertexElement::BoneIds, VertexFormat::Int4, offsetof(Vertex, m_BoneIDs)},
+        {4, VertexElement::Weights, VertexFormat::Float4, offsetof(Vertex, m_Weights)},
+    }};
+    return layout;
+}
+
+const VertexLayout &VertexLayout::Static() {
+    static const VertexLayout layout{20, {
+        {0, VertexElement::Position, VertexFormat::Float3, 0},
+        {1, VertexElement::Normal, VertexFormat::Snorm10x3, 12},
+        {2, VertexElement::TexCoords, VertexFormat::Half2, 16},
+    }};
+    return layout;
+}
+
+const VertexLayout &VertexLayout::Skinned() {
+    static const VertexLayout layout{28, {
+        {0, VertexElement::Position, VertexFormat::Float3, 0},
+        {1, VertexElement::Normal, VertexFormat::Snorm10x3, 12},
+        {2, VertexElement::TexCoords, VertexFormat::Half2, 16},
+        {3, VertexElement::BoneIds, VertexFormat::UByte4, 20},
+        {4, VertexElement::Weights, VertexFormat::Unorm8x4, 24},
+    }};
+    return layout;
+}
+
+const VertexLayout &VertexLayout::For(bool skinned) {
+    if (!COMPACT_VERTICES)
+        return Full();
+    return skinned ? Skinned() : Static();
+}
+
+// Weights rounded to 1/255 so that they still add up to their sum
+static void QuantizeWeights(const Vertex &vertex, uint8_t *out) {
+    float sum = 0.f;
+    int total = 0, largest = 0;
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+        float weight = vertex.m_BoneIDs[i] >= 0 ? std::clamp(vertex.m_Weights[i], 0.f, 1.f) : 0.f;
+        out[i] = static_cast<uint8_t>(std::lround(weight * 255.f));
+        sum += weight;
+        total += out[i];
+        if (out[i] > out[largest])
+            largest = i;
+    }
+    int target = std::min(static_cast<int>(std::lround(sum * 255.f)), 255);
+    if (total != target && out[largest] > 0)
+        out[largest] = static_cast<uint8_t>(std::clamp(out[largest] + target - total, 0, 255));
+}
+
+static void PackAttribute(const VertexAttribute &attribute, const Vertex &vertex, unsigned char *out) {
+    switch (attribute.format) {
+    case VertexFormat::Float2:
+    case VertexFormat::Float3:
+    case VertexFormat::Float4:
+    case VertexFormat::Int4: {
+        // Full precision formats are copied from the field as is
+        static const size_t sizes[] = {8, 12, 16, 16};
+        size_t size = sizes[static_cast<int>(attribute.format)];
+        const void *field = nullptr;
+        switch (attribute.element) {
+        case VertexElement::Position: field = &vertex.Position; break;
+        case VertexElement::Normal: field = &vertex.Normal; break;
+        case VertexElement::TexCoords: field = &vertex.TexCoords; break;
+        case VertexElement::BoneIds: field = vertex.m_BoneIDs; break;
+        case VertexElement::Weights: field = vertex.m_Weights; break;
+        }
+        std::memcpy(out, field, size);
+        break;
+    }
+    case VertexFormat::Snorm10x3: {
+        uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.f));
+        std::memcpy(out, &packed, sizeof(packed));
+        break;
+    }
+    case VertexFormat::Half2: {
+        uint16_t packed[2] = {glm::packHalf1x16(vertex.TexCoords.x), glm::packHalf1x16(vertex.TexCoords.y)};
+        std::memcpy(out, packed, sizeof(packed));
+        break;
+    }
+    case VertexFormat::UByte4:
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+            int id = vertex.m_BoneIDs[i];
+            out[i] = id >= 0 && vertex.m_Weights[i] > 0.f ? static_cast<uint8_t>(id) : 0;
+        }
+        break;
+    case VertexFormat::Unorm8x4:
+        QuantizeWeights(vertex, out);
+        break;
+    }
+}
+
+void VertexLayout::Pack(ArrayView<Vertex> vertices, unsigned char *out) const {
+    for (size_t i = 0; i < vertices.size(); i++) {
+        for (auto &attribute : attributes)
+            PackAttribute(attribute, vertices[i], out + i * stride + attribute.offset);
+    }
+}
+
+void VertexLayout::Bind() const {
+    for (auto &attribute : attributes) {
+        auto offset = reinterpret_cast<void *>(static_cast<uintptr_t>(attribute.offset));
+        glEnableVertexAttribArray(attribute.location);
+        switch (attribute.format) {
+        case VertexFormat::Float2:
+            glVertexAttribPointer(attribute.location, 2, GL_FLOAT, GL_FALSE, stride, offset);
+            break;
+        case VertexFormat::Float3:
+            glVertexAttribPointer(attribute.location, 3, GL_FLOAT, GL_FALSE, stride, offset);
+            break;
+        case VertexFormat::Float4:
+            glVertexAttribPointer(attribute.location, 4, GL_FLOAT, GL_FALSE, stride, offset);
+            break;
+        case VertexFormat::Int4:
+            glVertexAttribIPointer(attribute.location, 4, GL_INT, stride, offset);
+            break;
+        case VertexFormat::Snorm10x3:
+            glVertexAttribPointer(attribute.location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset);
+            break;
+        case VertexFormat::Half2:
+            glVertexAttribPointer(attribute.location, 2, GL_HALF_FLOAT, GL_FALSE, stride, offset);
+            break;
+        case VertexFormat::UByte4:
+            glVertexAttribIPointer(attribute.location, 4, GL_UNSIGNED_BYTE, stride, offset);
+            break;
+        case VertexFormat::Unorm8x4:
+            glVertexAttribPointer(attribute.location, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, offset);
+            break;
+        }
+    }
+}
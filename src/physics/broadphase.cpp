@@ -0,0 +1,333 @@
+#include "broadphase.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool Overlap(const AABB &a, const AABB &b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x
+        && a.min.y <= b.max.y && b.min.y <= a.max.y
+        && a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+//             Sweep and prune
+
+void SweepAndPrune::Update(ObjectHandle handle, AABB bounds) {
+    int slot = GetHandleIndex(handle);
+    if (slot >= static_cast<int>(m_HandleToProxy.size()))
+        m_HandleToProxy.resize(slot + 1, -1);
+
+    if (m_HandleToProxy[slot] == -1) {
+        m_HandleToProxy[slot] = static_cast<int>(m_Proxies.size());
+        m_Proxies.push_back(Proxy{handle, bounds});
+        return;
+    }
+    m_Proxies[m_HandleToProxy[slot]] = Proxy{handle, bounds};
+}
+
+void SweepAndPrune::Remove(ObjectHandle handle) {
+    int slot = GetHandleIndex(handle);
+    if (handle < 0 || slot >= static_cast<int>(m_HandleToProxy.size())
+            || m_HandleToProxy[slot] == -1
+            || m_Proxies[m_HandleToProxy[slot]].handle != handle)
+        return;
+
+    // Keep the order, so next sort is still cheap
+    int removed = m_HandleToProxy[slot];
+    m_Proxies.erase(m_Proxies.begin() + removed);
+    m_HandleToProxy[slot] = -1;
+    for (int i = removed; i < m_Proxies.size(); i++)
+        m_HandleToProxy[GetHandleIndex(m_Proxies[i].handle)] = i;
+}
+
+void SweepAndPrune::Sort() {
+    // Insertion sort: proxies are almost sorted since the last frame
+    for (int i = 1; i < m_Proxies.size(); i++) {
+        Proxy proxy = m_Proxies[i];
+        int j = i - 1;
+        while (j >= 0 && m_Proxies[j].bounds.min.x > proxy.bounds.min.x) {
+            m_Proxies[j + 1] = m_Proxies[j];
+            j--;
+        }
+        m_Proxies[j + 1] = proxy;
+    }
+    m_MaxWidth = 0.f;
+    for (int i = 0; i < m_Proxies.size(); i++) {
+        m_HandleToProxy[GetHandleIndex(m_Proxies[i].handle)] = i;
+        m_MaxWidth = std::max(m_MaxWidth, m_Proxies[i].bounds.max.x - m_Proxies[i].bounds.min.x);
+    }
+}
+
+void SweepAndPrune::FindPairs(std::vector<BroadphasePair> *out) {
+    Sort();
+    for (int i = 0; i < m_Proxies.size(); i++) {
+        const AABB &bounds = m_Proxies[i].bounds;
+        for (int j = i + 1; j < m_Proxies.size(); j++) {
+            if (m_Proxies[j].bounds.min.x > bounds.max.x)
+                break;
+            if (Overlap(bounds, m_Proxies[j].bounds))
+                out->push_back(BroadphasePair{m_Proxies[i].handle, m_Proxies[j].handle});
+        }
+    }
+}
+
+void SweepAndPrune::Refresh() {
+    Sort();
+}
+
+void SweepAndPrune::Raycast(const Ray &ray, float maxDistance, RayVisitor visit) const {
+    Vec3 inverse = InverseDirection(ray.direction);
+    auto visitProxy = [&](const Proxy &proxy) {
+        float entry = RayEntry(proxy.bounds, ray.origin, inverse, maxDistance);
+        if (entry <= maxDistance)
+            maxDistance = std::min(maxDistance, visit(proxy.handle, entry));
+    };
+
+    // Proxies are sorted by min.x and end before min.x + m_MaxWidth, so the ones
+    // ending behind the origin are skipped and the walk stops at the first proxy
+    // the ray can not reach along x before `maxDistance`
+    if (ray.direction.x >= 0.f) {
+        auto first = std::lower_bound(m_Proxies.begin(), m_Proxies.end(), ray.origin.x - m_MaxWidth,
+                                      [](const Proxy &proxy, float x) { return proxy.bounds.min.x < x; });
+        for (auto it = first; it != m_Proxies.end(); it++) {
+            if ((it->bounds.min.x - ray.origin.x) * inverse.x > maxDistance)
+                break;
+            visitProxy(*it);
+        }
+        return;
+    }
+    auto last = std::upper_bound(m_Proxies.begin(), m_Proxies.end(), ray.origin.x,
+                                 [](float x, const Proxy &proxy) { return x < proxy.bounds.min.x; });
+    for (auto it = last; it != m_Proxies.begin(); it--) {
+        const Proxy &proxy = *(it - 1);
+        if ((proxy.bounds.min.x + m_MaxWidth - ray.origin.x) * inverse.x > maxDistance)
+            break;
+        visitProxy(proxy);
+    }
+}
+
+void SweepAndPrune::Query(AABB bounds, std::vector<ObjectHandle> *out) {
+    Sort();
+    for (auto &proxy : m_Proxies) {
+        if (proxy.bounds.min.x > bounds.max.x)
+            break;
+        if (Overlap(bounds, proxy.bounds))
+            out->push_back(proxy.handle);
+    }
+}
+
+//             Uniform grid
+
+UniformGrid::UniformGrid(float cellSize) : m_CellSize(cellSize) {}
+
+Vec3Int UniformGrid::GetCell(Vec3 point) const {
+    return Vec3Int(glm::floor(point / m_CellSize));
+}
+
+UniformGrid::CellKey UniformGrid::GetKey(Vec3Int cell) const {
+    const CellKey mask = (1 << 21) - 1;
+    return ((cell.x & mask) << 42) | ((cell.y & mask) << 21) | (cell.z & mask);
+}
+
+bool UniformGrid::IsOversized(Vec3Int minCell, Vec3Int maxCell) const {
+    Vec3Int size = maxCell - minCell + Vec3Int(1);
+    return static_cast<int64_t>(size.x) * size.y * size.z > BROADPHASE_MAX_CELLS;
+}
+
+const AABB &UniformGrid::GetBounds(ObjectHandle handle) const {
+    return m_Bounds[GetHandleIndex(handle)];
+}
+
+void UniformGrid::Update(ObjectHandle handle, AABB bounds) {
+    int slot = GetHandleIndex(handle);
+    if (slot >= static_cast<int>(m_HandleToIndex.size())) {
+        m_HandleToIndex.resize(slot + 1, -1);
+        m_Bounds.resize(slot + 1);
+        m_IsOversized.resize(slot + 1, false);
+    }
+    if (m_HandleToIndex[slot] == -1) {
+        m_HandleToIndex[slot] = static_cast<int>(m_Handles.size());
+        m_Handles.push_back(handle);
+    }
+    m_Handles[m_HandleToIndex[slot]] = handle;
+    m_Bounds[slot] = bounds;
+    m_Dirty = true;
+}
+
+void UniformGrid::Remove(ObjectHandle handle) {
+    int slot = GetHandleIndex(handle);
+    if (handle < 0 || slot >= static_cast<int>(m_HandleToIndex.size())
+            || m_HandleToIndex[slot] == -1
+            || m_Handles[m_HandleToIndex[slot]] != handle)
+        return;
+
+    int removed = m_HandleToIndex[slot];
+    m_Handles[removed] = m_Handles.back();
+    m_HandleToIndex[GetHandleIndex(m_Handles[removed])] = removed;
+    m_Handles.pop_back();
+    m_HandleToIndex[slot] = -1;
+    m_Dirty = true;
+}
+
+void UniformGrid::Rebuild() {
+    // Keep allocated buckets alive between frames unless the map grew too much
+    if (m_Cells.size() > 8 * m_Handles.size() + 64) {
+        m_Cells.clear();
+    } else {
+        for (auto &cell : m_Cells)
+            cell.second.clear();
+    }
+    m_Oversized.clear();
+    m_MinCell = Vec3Int(std::numeric_limits<int>::max());
+    m_MaxCell = Vec3Int(std::numeric_limits<int>::min());
+
+    for (auto handle : m_Handles) {
+        int slot = GetHandleIndex(handle);
+        Vec3Int minCell = GetCell(m_Bounds[slot].min);
+        Vec3Int maxCell = GetCell(m_Bounds[slot].max);
+        m_IsOversized[slot] = IsOversized(minCell, maxCell);
+        if (m_IsOversized[slot]) {
+            m_Oversized.push_back(handle);
+            continue;
+        }
+        m_MinCell = glm::min(m_MinCell, minCell);
+        m_MaxCell = glm::max(m_MaxCell, maxCell);
+        for (int x = minCell.x; x <= maxCell.x; x++)
+            for (int y = minCell.y; y <= maxCell.y; y++)
+                for (int z = minCell.z; z <= maxCell.z; z++)
+                    m_Cells[GetKey(Vec3Int(x, y, z))].push_back(handle);
+    }
+    m_Dirty = false;
+}
+
+void UniformGrid::FindPairs(std::vector<BroadphasePair> *out) {
+    Rebuild();
+
+    for (auto &cell : m_Cells) {
+        auto &handles = cell.second;
+        for (int i = 0; i < handles.size(); i++) {
+            const AABB &a = GetBounds(handles[i]);
+            for (int j = i + 1; j < handles.size(); j++) {
+                const AABB &b = GetBounds(handles[j]);
+                if (!Overlap(a, b))
+                    continue;
+                // Pair shares several cells, report it only from the one
+                // containing min corner of the intersection
+                if (GetKey(GetCell(glm::max(a.min, b.min))) != cell.first)
+                    continue;
+                out->push_back(BroadphasePair{handles[i], handles[j]});
+            }
+        }
+    }
+
+    for (int i = 0; i < m_Oversized.size(); i++) {
+        ObjectHandle big = m_Oversized[i];
+        for (auto handle : m_Handles) {
+            // Pairs of two oversized proxies are reported by the first one
+            int slot = GetHandleIndex(handle);
+            if (m_IsOversized[slot] && m_HandleToIndex[slot] <= m_HandleToIndex[GetHandleIndex(big)])
+                continue;
+            if (Overlap(GetBounds(big), m_Bounds[slot]))
+                out->push_back(BroadphasePair{big, handle});
+        }
+    }
+}
+
+void UniformGrid::Query(AABB bounds, std::vector<ObjectHandle> *out) {
+    Vec3Int minCell = GetCell(bounds.min);
+    Vec3Int maxCell = GetCell(bounds.max);
+    if (IsOversized(minCell, maxCell)) {
+        for (auto handle : m_Handles) {
+            if (Overlap(bounds, GetBounds(handle)))
+                out->push_back(handle);
+        }
+        return;
+    }
+
+    if (m_Dirty)
+        Rebuild();
+
+    size_t first = out->size();
+    for (int x = minCell.x; x <= maxCell.x; x++) {
+        for (int y = minCell.y; y <= maxCell.y; y++) {
+            for (int z = minCell.z; z <= maxCell.z; z++) {
+                auto it = m_Cells.find(GetKey(Vec3Int(x, y, z)));
+                if (it == m_Cells.end())
+                    continue;
+                for (auto handle : it->second) {
+                    if (Overlap(bounds, GetBounds(handle)))
+                        out->push_back(handle);
+                }
+            }
+        }
+    }
+    for (auto handle : m_Oversized) {
+        if (Overlap(bounds, GetBounds(handle)))
+            out->push_back(handle);
+    }
+    std::sort(out->begin() + first, out->end());
+    out->erase(std::unique(out->begin() + first, out->end()), out->end());
+}
+
+void UniformGrid::Refresh() {
+    if (m_Dirty)
+        Rebuild();
+}
+
+void UniformGrid::Raycast(const Ray &ray, float maxDistance, RayVisitor visit) const {
+    Vec3 inverse = InverseDirection(ray.direction);
+    for (auto handle : m_Oversized) {
+        float entry = RayEntry(GetBounds(handle), ray.origin, inverse, maxDistance);
+        if (entry <= maxDistance)
+            maxDistance = std::min(maxDistance, visit(handle, entry));
+    }
+    if (m_Oversized.size() == m_Handles.size())
+        return;
+
+    // Only the part of the ray crossing occupied cells is walked
+    AABB extent{Vec3(m_MinCell) * m_CellSize, Vec3(m_MaxCell + Vec3Int(1)) * m_CellSize};
+    float cellEntry = RayEntry(extent, ray.origin, inverse, maxDistance);
+    if (cellEntry > maxDistance)
+        return;
+    Vec3Int cell = glm::clamp(GetCell(ray.origin + ray.direction * cellEntry), m_MinCell, m_MaxCell);
+
+    // Ray crosses the next cell border along axis i at distance next[i]
+    Vec3Int step;
+    Vec3 next, delta;
+    for (int i = 0; i < 3; i++) {
+        step[i] = ray.direction[i] > 0.f ? 1 : (ray.direction[i] < 0.f ? -1 : 0);
+        if (step[i] == 0) {
+            next[i] = delta[i] = std::numeric_limits<float>::infinity();
+            continue;
+        }
+        float border = (cell[i] + (step[i] > 0 ? 1 : 0)) * m_CellSize;
+        next[i] = (border - ray.origin[i]) * inverse[i];
+        delta[i] = m_CellSize * std::abs(inverse[i]);
+    }
+
+    bool first = true;
+    while (cellEntry <= maxDistance) {
+        float cellExit = std::min({next.x, next.y, next.z});
+        // Proxy spanning several cells is visited from the one the ray enters it in.
+        // Borders are blurred a bit, so rounding can only visit it twice
+        float tolerance = 1e-4f * (m_CellSize + cellExit);
+        auto it = m_Cells.find(GetKey(cell));
+        if (it != m_Cells.end()) {
+            for (auto handle : it->second) {
+                float entry = RayEntry(GetBounds(handle), ray.origin, inverse, maxDistance);
+                if (entry > maxDistance || entry > cellExit + tolerance
+                        || (!first && entry < cellEntry - tolerance))
+                    continue;
+                maxDistance = std::min(maxDistance, visit(handle, entry));
+            }
+        }
+        first = false;
+
+        int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+        cell[axis] += step[axis];
+        if (cell[axis] < m_MinCell[axis] || cell[axis] > m_MaxCell[axis])
+            break;
+        cellEntry = next[axis];
+        next[axis] += delta[axis];
+    }
+}
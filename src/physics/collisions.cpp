@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <variant>
 #include <optional>
 #include "logger.hpp"
@@ -9,65 +13,101 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-inline bool ClipToPlane(const Plane& plane,
-        const Line& line, Vec3* outPoint) {
-    Vec3 ab = line.end - line.start;
-    float nAB = glm::dot(plane.normal, ab);
-    if (isCloseToZero(nAB)) {
-        return false;
-    }
-
-    float nA = glm::dot(plane.normal, line.start);
-    float t = (plane.d - nA) / nAB;
-
-    if (t >= 0.0f && t <= 1.0f) {
-        if (outPoint != nullptr) {
-            *outPoint = line.start + ab * t;
+// Adds points where `edges` enter and leave `box` to `sum`, returns their number.
+// Edges are clipped against the slabs of the box in its local space
+static int ClipEdgesToBox(const std::array<Line, 12> &edges, const OBB &box, Vec3 *sum) {
+    Mat3 toLocal = glm::transpose(box.axis);
+    Vec3 local(0.f);
+    int count = 0;
+    for (auto &edge : edges) {
+        Vec3 start = toLocal * (edge.start - box.center);
+        Vec3 delta = toLocal * (edge.end - edge.start);
+        Vec3 inverse = InverseDirection(delta);
+        Vec3 t0 = (-box.halfWidth - start) * inverse;
+        Vec3 t1 = (box.halfWidth - start) * inverse;
+        Vec3 near = glm::min(t0, t1), far = glm::max(t0, t1);
+        float enter = glm::max(glm::max(near.x, near.y), near.z);
+        float leave = glm::min(glm::min(far.x, far.y), far.z);
+        if (enter > leave)
+            continue;
+        if (enter >= 0.f && enter <= 1.f) {
+            local += start + delta * enter;
+            count++;
+        }
+        if (leave > enter && leave >= 0.f && leave <= 1.f) {
+            local += start + delta * leave;
+            count++;
         }
-        return true;
     }
-
-    return false;
-}
-
-inline std::vector<Vec3> ClipEdgesToOBB(
-        const std::vector<Line>& edges, OBB obb) {
-    std::vector<Vec3> result;
-    result.reserve(edges.size());
-    Vec3 intersection;
-
-    std::vector<Plane> planes = obb.GetPlanes();
-    for (int i = 0; i < planes.size(); i++) {
-        for (int j = 0; j < edges.size(); j++) {
-            if (ClipToPlane(planes[i], edges[j], &intersection)) {
-                if (obb.IsPointIn(intersection)) {
-                    result.push_back(intersection);
-                }
-            }
+    *sum += static_cast<float>(count) * box.center + box.axis * local;
+    return count;
+}
+
+// Interval of `box` on axis (x, y, z), which does not need to be normalized
+static inline void ProjectBox(const OBB &box, float x, float y, float z, float *min, float *max) {
+    const Mat3 &a = box.axis;
+    float center = x * box.center.x + y * box.center.y + z * box.center.z;
+    float radius = std::abs(x * a[0].x + y * a[0].y + z * a[0].z) * box.halfWidth.x
+        + std::abs(x * a[1].x + y * a[1].y + z * a[1].z) * box.halfWidth.y
+        + std::abs(x * a[2].x + y * a[2].y + z * a[2].z) * box.halfWidth.z;
+    *min = center - radius;
+    *max = center + radius;
+}
+
+// Separating axis test of two boxes over their face normals and cross
+// products of their edges. Returns false if the boxes are separated,
+// otherwise sets `axis` to the unit axis of the smallest overlap, pointing
+// from `a` to `b`, and `depth` to the overlap along it.
+// Axes are stored coordinate by coordinate and projected unnormalized,
+// so overlaps on all of them are computed by a loop of vector instructions.
+// The last axis is zero padding, it makes the count a multiple of vector width
+static bool SeparatingAxisTest(const OBB &a, const OBB &b, Vec3 *axis, float *depth) {
+    constexpr int AXES = 16;
+    float x[AXES], y[AXES], z[AXES];
+    x[AXES - 1] = y[AXES - 1] = z[AXES - 1] = 0.f;
+    for (int i = 0; i < 3; i++) {
+        x[i] = a.axis[i].x, y[i] = a.axis[i].y, z[i] = a.axis[i].z;
+        x[3 + i] = b.axis[i].x, y[3 + i] = b.axis[i].y, z[3 + i] = b.axis[i].z;
+        for (int j = 0; j < 3; j++) {
+            Vec3 edges = glm::cross(a.axis[i], b.axis[j]);
+            int k = 6 + i * 3 + j;
+            x[k] = edges.x, y[k] = edges.y, z[k] = edges.z;
         }
     }
 
-    return result;
-}
-
-inline std::vector<Vec3> ClipEdgesToAABB(
-        const std::vector<Line>& edges, AABB aabb) {
-    std::vector<Vec3> result;
-    result.reserve(edges.size());
-    Vec3 intersection;
-
-    std::vector<Plane> planes = aabb.GetPlanes();
-    for (int i = 0; i < planes.size(); i++) {
-        for (int j = 0; j < edges.size(); j++) {
-            if (ClipToPlane(planes[i], edges[j], &intersection)) {
-                if (aabb.IsPointIn(intersection)) {
-                    result.push_back(intersection);
-                }
-            }
+    // Overlaps scale with the length of the axis while their signs do not,
+    // so only the search for the smallest one needs to normalize
+    float overlap[AXES], length2[AXES];
+    bool flip[AXES];
+    for (int i = 0; i < AXES; i++) {
+        float minA, maxA, minB, maxB;
+        ProjectBox(a, x[i], y[i], z[i], &minA, &maxA);
+        ProjectBox(b, x[i], y[i], z[i], &minB, &maxB);
+        overlap[i] = std::min(maxA, maxB) - std::max(minA, minB);
+        length2[i] = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        flip[i] = minB < minA;
+    }
+
+    int best = -1;
+    *depth = std::numeric_limits<float>::max();
+    for (int i = 0; i < AXES; i++) {
+        // Cross product of parallel edges or padding
+        if (length2[i] < 1e-6f)
+            continue;
+        if (overlap[i] <= 0.f)
+            return false;
+        float normalized = overlap[i] / std::sqrt(length2[i]);
+        if (normalized < *depth) {
+            *depth = normalized;
+            best = i;
         }
     }
-
-    return result;
+    if (best == -1)
+        return false;
+    *axis = glm::normalize(Vec3(x[best], y[best], z[best]));
+    if (flip[best])
+        *axis = -*axis;
+    return true;
 }
 
 CollisionManifold CollidePrimitive(OBB obb, AABB aabb) {
@@ -76,89 +116,26 @@ CollisionManifold CollidePrimitive(OBB obb, AABB aabb) {
     return res;
 }
 
-inline float PenetrationDepth(OBB& o, AABB& a,
-        const Vec3& axis, bool* outShouldFlip) {
-    Interval i1 = o.GetInterval(Norm(axis));
-    Interval i2 = a.GetInterval(Norm(axis));
-
-    if (!((i2.min <= i1.max) && (i1.min <= i2.max))) {
-        return 0.0f;  // No penerattion
-    }
-
-    float len1 = i1.max - i1.min;
-    float len2 = i2.max - i2.min;
-    float min = fminf(i1.min, i2.min);
-    float max = fmaxf(i1.max, i2.max);
-    float length = max - min;
-
-    if (outShouldFlip != 0) {
-        *outShouldFlip = (i2.min < i1.min);
-    }
-
-    return (len1 + len2) - length;
-}
-
 CollisionManifold CollidePrimitive(AABB aabb, OBB obb) {
     CollisionManifold res;
-    Vec3 test[15] = {
-        Vec3(1, 0, 0),
-        // AABB axis 1
-        Vec3(0, 1, 0),
-        // AABB axis 2
-        Vec3(0, 0, 1),
-        // AABB axis 3
-        obb.axis[0],  // OBB axis 1
-        obb.axis[1],  // OBB axis 2
-        obb.axis[2]   // OBB axis 3
-        // We will fill out the remaining axis in the next step
-    };
-
-    for (int i = 0; i < 3; i++) {  // Fill out rest of axis
-        test[6 + i * 3 + 0] = glm::cross(test[i], test[0]);
-        test[6 + i * 3 + 1] = glm::cross(test[i], test[1]);
-        test[6 + i * 3 + 2] = glm::cross(test[i], test[2]);
-    }
-
-    Vec3 *hitNormal = nullptr;
-    bool shouldFlip;
-
-    for (int i = 0; i < 15; i++) {
-        if (glm::length(test[i]) < 0.001f) {
-            continue;
-        }
-        float depth = PenetrationDepth(obb, aabb, test[i], &shouldFlip);
-        if (depth <= 0.0f) {
-            return res;
-        } else if (depth < res.penetrationDistance) {
-            if (shouldFlip) {
-                test[i] = test[i] * -1.0f;
-            }
-            res.penetrationDistance = depth;
-            hitNormal = &test[i];
-        }
-    }
+    Vec3 axis;
+    OBB box{(aabb.max + aabb.min) * 0.5f, Mat3(1.f), (aabb.max - aabb.min) * 0.5f};
+    if (!SeparatingAxisTest(box, obb, &axis, &res.penetrationDistance))
+        return CollisionManifold();
+    // Axis from the OBB to the AABB
+    axis = -axis;
 
-    if (hitNormal == nullptr) {
-        return res;
-    }
-
-    Vec3 axis = Norm(*hitNormal);
-
-    std::vector<Vec3> c1 = ClipEdgesToOBB(aabb.GetEdges(), obb);
-    std::vector<Vec3> c2 = ClipEdgesToAABB(obb.GetEdges(), aabb);
+    Vec3 p = Vec3(0);
+    int count = ClipEdgesToBox(aabb.GetEdges(), obb, &p) + ClipEdgesToBox(obb.GetEdges(), box, &p);
 
-    if (c1.size() == 0 && c2.size() == 0) {
+    if (count == 0) {
         res.collisionPoint = obb.ClosestPoint((aabb.max + aabb.min) / 2.f);
         res.collide = true;
         res.collisionNormal = axis;
         return res;
     }
 
-    Vec3 p = Vec3(0);
-    for (auto i : c1) p += i;
-    for (auto i : c2) p += i;
-
-    res.collisionPoint = p / static_cast<float>(c1.size() + c2.size());
+    res.collisionPoint = p / static_cast<float>(count);
 
     Interval i = obb.GetInterval(axis);
     float distance = (i.max - i.min) * 0.5f
@@ -224,83 +201,23 @@ bool CollidePrimitive(Ray, OBB) {
     return false;
 }
 
-inline float PenetrationDepth(OBB& o1, OBB& o2,
-        const Vec3& axis, bool* outShouldFlip) {
-    Interval i1 = o1.GetInterval(Norm(axis));
-    Interval i2 = o2.GetInterval(Norm(axis));
-
-    if (!((i2.min <= i1.max) && (i1.min <= i2.max))) {
-        return 0.0f;  // No penerattion
-    }
-
-    float len1 = i1.max - i1.min;
-    float len2 = i2.max - i2.min;
-    float min = fminf(i1.min, i2.min);
-    float max = fmaxf(i1.max, i2.max);
-    float length = max - min;
-
-    if (outShouldFlip != 0) {
-        *outShouldFlip = (i2.min < i1.min);
-    }
-
-    return (len1 + len2) - length;
-}
-
 CollisionManifold CollidePrimitive(OBB a, OBB b) {
     CollisionManifold res;
-    Vec3 test[15] = {  // Face axis
-        a.axis[0],
-        a.axis[1],
-        a.axis[2],
-        b.axis[0],
-        b.axis[1],
-        b.axis[2],
-    };
-    for (int i = 0; i < 3; i++) {  // Fill out rest of axis
-        test[6 + i * 3 + 0] = glm::cross(test[i], test[0]);
-        test[6 + i * 3 + 1] = glm::cross(test[i], test[1]);
-        test[6 + i * 3 + 2] = glm::cross(test[i], test[2]);
-    }
-
-    Vec3 *hitNormal = nullptr;
-    bool shouldFlip;
-
-    for (int i = 0; i < 15; i++) {
-        if (glm::length(test[i]) < 0.001f) {
-            continue;
-        }
-        float depth = PenetrationDepth(a, b, test[i], &shouldFlip);
-        if (depth <= 0.0f) {
-            return res;
-        } else if (depth < res.penetrationDistance) {
-            if (shouldFlip) {
-                test[i] = test[i] * -1.0f;
-            }
-            res.penetrationDistance = depth;
-            hitNormal = &test[i];
-        }
-    }
+    Vec3 axis;
+    if (!SeparatingAxisTest(a, b, &axis, &res.penetrationDistance))
+        return CollisionManifold();
 
-    if (hitNormal == nullptr) {
-        return res;
-    }
-    Vec3 axis = Norm(*hitNormal);
-
-    std::vector<Vec3> c1 = ClipEdgesToOBB(b.GetEdges(), a);
-    std::vector<Vec3> c2 = ClipEdgesToOBB(a.GetEdges(), b);
+    Vec3 p = Vec3(0);
+    int count = ClipEdgesToBox(b.GetEdges(), a, &p) + ClipEdgesToBox(a.GetEdges(), b, &p);
 
-    if (c1.size() == 0 && c2.size() == 0) {
+    if (count == 0) {
         res.collisionPoint = a.ClosestPoint(b.center);
         res.collide = true;
         res.collisionNormal = -axis;
         return res;
     }
 
-    Vec3 p = Vec3(0);
-    for (auto i : c1) p += i;
-    for (auto i : c2) p += i;
-
-    res.collisionPoint = p / static_cast<float>(c1.size() + c2.size());
+    res.collisionPoint = p / static_cast<float>(count);
 
     Interval i = a.GetInterval(axis);
     float distance = (i.max - i.min) * 0.5f
@@ -648,25 +565,40 @@ CollisionManifold CollidePrimitive(Triangle t1, Triangle t2) {
     return res;
 }
 
+static AABB BoundsOf(const AABB &aabb) {
+    return aabb;
+}
+
+static AABB BoundsOf(const Sphere &sphere) {
+    return AABB{sphere.center - Vec3(sphere.radius), sphere.center + Vec3(sphere.radius)};
+}
+
+static AABB BoundsOf(const Triangle &tri) {
+    return AABB{glm::min(glm::min(tri.a, tri.b), tri.c), glm::max(glm::max(tri.a, tri.b), tri.c)};
+}
+
+static AABB BoundsOf(const OBB &obb) {
+    Vec3 extents = glm::abs(obb.axis[0]) * obb.halfWidth[0]
+        + glm::abs(obb.axis[1]) * obb.halfWidth[1]
+        + glm::abs(obb.axis[2]) * obb.halfWidth[2];
+    return AABB{obb.center - extents, obb.center + extents};
+}
+
 // There should be an overload CollidePrimitive(T, Triangle);
 template<typename T>
 CollisionManifold CollideMeshAt(T t, Mesh *mesh, Transform transform) {
     CollisionManifold res;
-    // WARNING: This makes assumptions about data layout
-    Mat4 meshMat = glm::transpose(transform.GetTransformMatrix());
-    auto loadPos = [=](int i) {
-        int id = mesh->getIndices()[i];
-        Vec4 res = Vec4 {mesh->getPoints()[id].Position, 1.0} * meshMat;
-
-        return Vec3{ res.x / res.w, res.y / res.w, res.z / res.w };
-    };
-    for (int i = 0; i < mesh->getLenIndices(); i+=3) {
-        Triangle tri = Triangle(loadPos(i), loadPos(i + 1), loadPos(i + 2));
-        auto manifold = CollidePrimitive(t, tri);
-        if (manifold.collide) {
-            return manifold;
-        }
-    }
+    Mat4 meshMat = transform.GetTransformMatrix();
+    // Bounds of the probe are moved to local space of the mesh,
+    // only triangles found there are transformed and tested
+    AABB bounds = BoundsOf(t);
+    bounds = AABB{bounds.min - Vec3(EPS), bounds.max + Vec3(EPS)}.TransformedBounds(glm::inverse(meshMat));
+    mesh->GetBVH().Query(bounds, [&](int triangle) {
+        auto manifold = CollidePrimitive(t, mesh->GetTriangle(triangle, meshMat));
+        if (manifold.collide)
+            res = manifold;
+        return manifold.collide;
+    });
     return res;
 }
 template CollisionManifold CollideMeshAt<AABB>(AABB, Mesh *, Transform);
@@ -677,21 +609,17 @@ template CollisionManifold CollideMeshAt<OBB>(OBB, Mesh *, Transform);
 CollisionManifold CollideMeshes(Mesh *mesh, Transform transform, Mesh *mesh2,
         Transform transform2) {
     CollisionManifold res;
-    // WARNING: This makes assumptions about data layout
-    Mat4 meshMat = glm::transpose(transform.GetTransformMatrix());
-    auto loadPos = [=](int i) {
-        int id = mesh->getIndices()[i];
-        Vec4 res = Vec4 {mesh->getPoints()[id].Position, 1.0} * meshMat;
-
-        return Vec3{ res.x / res.w, res.y / res.w, res.z / res.w };
-    };
-    for (int i = 0; i < mesh->getLenIndices(); i+=3) {
-        Triangle tri = Triangle(loadPos(i), loadPos(i + 1), loadPos(i + 2));
-        auto manifold = CollideMeshAt(tri, mesh2, transform2);
-        if (manifold.collide) {
-            return manifold;
-        }
-    }
+    Mat4 meshMat = transform.GetTransformMatrix();
+    Mat4 meshMat2 = transform2.GetTransformMatrix();
+    // Both hierarchies are descended together in local space of the first mesh
+    Mat4 secondToFirst = glm::inverse(meshMat) * meshMat2;
+    MeshBVH::QueryPairs(mesh->GetBVH(), mesh2->GetBVH(), secondToFirst, [&](int first, int second) {
+        auto manifold = CollidePrimitive(mesh->GetTriangle(first, meshMat),
+            mesh2->GetTriangle(second, meshMat2));
+        if (manifold.collide)
+            res = manifold;
+        return manifold.collide;
+    });
     return res;
 }
 
@@ -826,3 +754,55 @@ std::optional<float> CollisionPrimitive(Ray r, OBB o) {
     return tmin;
 }
 
+// Möller–Trumbore intersection, both sides of the triangle are hit.
+// Direction does not need to be normalized, distance is in its units
+static std::optional<float> IntersectTriangle(Vec3 origin, Vec3 direction, Vec3 a, Vec3 b, Vec3 c) {
+    Vec3 edge1 = b - a;
+    Vec3 edge2 = c - a;
+    Vec3 p = glm::cross(direction, edge2);
+    float det = glm::dot(edge1, p);
+    if (det == 0.f)
+        return {};
+
+    float inverseDet = 1.f / det;
+    Vec3 s = origin - a;
+    float u = glm::dot(s, p) * inverseDet;
+    if (u < 0.f || u > 1.f)
+        return {};
+    Vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(direction, q) * inverseDet;
+    if (v < 0.f || u + v > 1.f)
+        return {};
+    float t = glm::dot(edge2, q) * inverseDet;
+    if (t < 0.f)
+        return {};
+    return t;
+}
+
+std::optional<float> CollisionPrimitive(Ray r, Triangle t) {
+    return IntersectTriangle(r.origin, r.direction, t.a, t.b, t.c);
+}
+
+std::optional<float> CollisionMeshAt(Ray ray, Mesh *mesh, Transform transform) {
+    const MeshBVH &bvh = mesh->GetBVH();
+    if (bvh.IsEmpty())
+        return {};
+    // Affine maps keep ray parameters, so distances found in local space
+    // of the mesh are world distances along the normalized world direction
+    Mat4 inverse = glm::inverse(transform.GetTransformMatrix());
+    Vec3 origin = Vec3(inverse * Vec4(ray.origin, 1.f));
+    Vec3 direction = Vec3(inverse * Vec4(ray.direction, 0.f));
+    const Vertex *points = mesh->getPoints();
+    const unsigned int *indices = mesh->getIndices();
+
+    std::optional<float> res;
+    bvh.Raycast(origin, direction, std::numeric_limits<float>::max(), [&](int triangle) {
+        const unsigned int *corners = indices + 3 * triangle;
+        auto hit = IntersectTriangle(origin, direction, points[corners[0]].Position,
+            points[corners[1]].Position, points[corners[2]].Position);
+        if (hit && (!res || *hit < *res))
+            res = hit;
+        return res ? *res : std::numeric_limits<float>::max();
+    });
+    return res;
+}
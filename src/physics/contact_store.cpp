@@ -0,0 +1,51 @@
+#include "contact_store.hpp"
+
+#include <algorithm>
+
+uint64_t ContactStore::GetKey(ObjectHandle a, ObjectHandle b) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) | static_cast<uint32_t>(b);
+}
+
+void ContactStore::Clear() {
+    m_Keys.clear();
+    m_Contacts.clear();
+}
+
+void ContactStore::Add(ObjectHandle a, ObjectHandle b, CollisionManifold manifold) {
+    m_Contacts.push_back(Contact{a, b, manifold});
+    manifold.collisionNormal *= -1;
+    m_Contacts.push_back(Contact{b, a, manifold});
+}
+
+void ContactStore::Finalize() {
+    std::sort(m_Contacts.begin(), m_Contacts.end(), [](const Contact &lhs, const Contact &rhs) {
+        return GetKey(lhs.a, lhs.b) < GetKey(rhs.a, rhs.b);
+    });
+    // Keys are kept separately to make binary search cache friendly
+    m_Keys.resize(m_Contacts.size());
+    for (int i = 0; i < m_Contacts.size(); i++)
+        m_Keys[i] = GetKey(m_Contacts[i].a, m_Contacts[i].b);
+}
+
+const CollisionManifold *ContactStore::Find(ObjectHandle a, ObjectHandle b) const {
+    uint64_t key = GetKey(a, b);
+    auto it = std::lower_bound(m_Keys.begin(), m_Keys.end(), key);
+    if (it == m_Keys.end() || *it != key)
+        return nullptr;
+    return &m_Contacts[it - m_Keys.begin()].manifold;
+}
+
+std::pair<const Contact *, const Contact *> ContactStore::GetContacts(ObjectHandle a) const {
+    auto first = std::lower_bound(m_Keys.begin(), m_Keys.end(), GetKey(a, 0));
+    auto last = std::lower_bound(first, m_Keys.end(), GetKey(a + 1, 0));
+    const Contact *data = m_Contacts.data();
+    return {data + (first - m_Keys.begin()), data + (last - m_Keys.begin())};
+}
+
+const Contact *ContactStore::begin() const {
+    return m_Contacts.data();
+}
+
+const Contact *ContactStore::end() const {
+    return m_Contacts.data() + m_Contacts.size();
+}
@@ -1,3 +1,4 @@
+#include <cmath>
 #include "geometry_primitives.hpp"
 #include "logger.hpp"
 #include <glm/gtx/norm.hpp>
@@ -18,9 +19,8 @@ Plane::Plane(Vec3 normal, float distance) {
     this->d = distance;
 }
 
-std::vector<Plane> AABB::GetPlanes() {
-    std::vector<Plane> result;
-    result.resize(6);
+std::array<Plane, 6> AABB::GetPlanes() {
+    std::array<Plane, 6> result;
     Vec3 center = (max + min) * 0.5f;
 
     result[0] = Plane(
@@ -34,7 +34,7 @@ std::vector<Plane> AABB::GetPlanes() {
     result[4] = Plane(
             Vec3(0, 0, 1), glm::dot(Vec3(0, 0, 1), Vec3(center.x, center.y, max.z)));
     result[5] = Plane(
-            Vec3(0, 0, -1), -glm::dot(Vec3(0, 0, -1), Vec3(center.x, center.y, min.z)));
+            Vec3(0, 0, -1), -glm::dot(Vec3(0, 0, 1), Vec3(center.x, center.y, min.z)));
 
     return result;
 }
@@ -48,9 +48,8 @@ bool AABB::IsPointIn(Vec3 point) {
             || point.z > max.z);
 }
 
-std::vector<Vec3> AABB::GetVertices() {
-    std::vector<Vec3> v;
-    v.resize(8);
+std::array<Vec3, 8> AABB::GetVertices() {
+    std::array<Vec3, 8> v;
 
     v[0] = Vec3(max.x, max.y, max.z);
     v[1] = Vec3(min.x, max.y, max.z);
@@ -64,19 +63,18 @@ std::vector<Vec3> AABB::GetVertices() {
     return v;
 }
 
-std::vector<Line> AABB::GetEdges() {
-    std::vector<Line> result;
-    result.reserve(12);
-    std::vector<Vec3> v = GetVertices();
+std::array<Line, 12> AABB::GetEdges() {
+    std::array<Line, 12> result;
+    std::array<Vec3, 8> v = GetVertices();
 
     int index[][2] = {  // Indices of edge-vertices
         {6, 1}, {6, 3}, {6, 4}, {2, 7}, {2, 5}, {2, 0},
         {0, 1}, {0, 3}, {7, 1}, {7, 4}, {4, 5}, {5, 3}
     };
     for (int j = 0; j < 12; ++j) {
-        result.push_back(Line{
+        result[j] = Line{
                 v[index[j][0]],
-                v[index[j][1]]});
+                v[index[j][1]]};
     }
 
     return result;
@@ -91,31 +89,15 @@ Vec3 AABB::ClosestPoint(Vec3 point) {
     return result;
 }
 
+// Extreme vertices take min or max of every coordinate depending on the sign
+// of the axis, so the interval needs no other vertices
 Interval AABB::GetInterval(Vec3 axis) {
-    Vec3 i = min;
-    Vec3 a = max;
-    Vec3 vertex[8] = {
-        Vec3(i.x, a.y, a.z),
-        Vec3(i.x, a.y, i.z),
-        Vec3(i.x, i.y, a.z),
-        Vec3(i.x, i.y, i.z),
-        Vec3(a.x, a.y, a.z),
-        Vec3(a.x, a.y, i.z),
-        Vec3(a.x, i.y, a.z),
-        Vec3(a.x, i.y, i.z)
-    };
-
-    Interval result;
-    result.min = result.max = glm::dot(axis, vertex[0]);
-    for (int i = 1; i < 8; ++i) {
-        float projection = glm::dot(axis, vertex[i]);
-        result.min = (projection < result.min) ?
-            projection : result.min;
-        result.max = (projection > result.max) ?
-            projection : result.max;
+    Vec3 low, high;
+    for (int i = 0; i < 3; i++) {
+        low[i] = axis[i] < 0.f ? max[i] : min[i];
+        high[i] = axis[i] < 0.f ? min[i] : max[i];
     }
-
-    return result;
+    return Interval{glm::dot(axis, low), glm::dot(axis, high)};
 }
 
 
@@ -147,13 +129,23 @@ float AABB::Distance2(Vec3 point) {
     return res;
 }
 
-AABB AABB::Transformed(Transform transform) {
+AABB AABB::Transformed(const Transform &transform) const {
     return AABB {
         min * transform.GetScale() + transform.GetTranslation(),
         max * transform.GetScale() + transform.GetTranslation()
     };
 }
 
+// Extent along every world axis is the sum of the half sizes projected on it
+AABB AABB::TransformedBounds(const Mat4 &matrix) const {
+    Vec3 center = Vec3(matrix * Vec4((min + max) * 0.5f, 1.f));
+    Vec3 half = (max - min) * 0.5f;
+    Vec3 extent = glm::abs(Vec3(matrix[0])) * half.x
+        + glm::abs(Vec3(matrix[1])) * half.y
+        + glm::abs(Vec3(matrix[2])) * half.z;
+    return AABB{center - extent, center + extent};
+}
+
 AABB AABB::PrevState(Vec3 velocity, float dt) {
     return AABB {
         min - velocity * dt,
@@ -238,7 +230,7 @@ float Triangle::Distance2(Vec3 point) {
     return glm::length2(point - ClosestPoint(point));
 }
 
-Triangle Triangle::Transformed(Transform transform) {
+Triangle Triangle::Transformed(const Transform &transform) const {
     auto mat = glm::transpose(transform.GetTransformMatrix());
     auto mul = [](Vec3 v, Mat4 mat) {
         Vec4 res = Vec4(v, 1) * mat;
@@ -247,7 +239,7 @@ Triangle Triangle::Transformed(Transform transform) {
     return Triangle(mul(a, mat), mul(b, mat), mul(c, mat));
 }
 
-Sphere Sphere::Transformed(Transform transform) {
+Sphere Sphere::Transformed(const Transform &transform) const {
     auto scale = transform.GetScale();
     if (scale.x != scale.y || scale.y != scale.z) {
         Logger::Error(
@@ -268,7 +260,7 @@ Ray::Ray(Vec3 from, Vec3 to) {
     direction = glm::normalize(to - from);
 }
 
-OBB OBB::Transformed(Transform transform) {
+OBB OBB::Transformed(const Transform &transform) const {
     return OBB {
         center + transform.GetTranslation(),
         Mat3(transform.GetRotation()) * axis,
@@ -288,9 +280,8 @@ bool OBB::IsPointIn(Vec3 point) {
     return true;
 }
 
-std::vector<Vec3> OBB::GetVertices() {
-    std::vector<Vec3> v;
-    v.resize(8);
+std::array<Vec3, 8> OBB::GetVertices() {
+    std::array<Vec3, 8> v;
 
     v[0] = center + axis[0] * halfWidth[0] + axis[1] * halfWidth[1]
         + axis[2] * halfWidth[2];
@@ -312,27 +303,25 @@ std::vector<Vec3> OBB::GetVertices() {
     return v;
 }
 
-std::vector<Line> OBB::GetEdges() {
-    std::vector<Line> result;
-    result.reserve(12);
-    std::vector<Vec3> v = GetVertices();
+std::array<Line, 12> OBB::GetEdges() {
+    std::array<Line, 12> result;
+    std::array<Vec3, 8> v = GetVertices();
 
     int index[][2] = {  // Indices of edge-vertices
         {6, 1}, {6, 3}, {6, 4}, {2, 7}, {2, 5}, {2, 0},
         {0, 1}, {0, 3}, {7, 1}, {7, 4}, {4, 5}, {5, 3}
     };
     for (int j = 0; j < 12; ++j) {
-        result.push_back(Line{
+        result[j] = Line{
                 v[index[j][0]],
-                v[index[j][1]]});
+                v[index[j][1]]};
     }
 
     return result;
 }
 
-std::vector<Plane> OBB::GetPlanes() {
-    std::vector<Plane> result;
-    result.resize(6);
+std::array<Plane, 6> OBB::GetPlanes() {
+    std::array<Plane, 6> result;
 
     result[0] = Plane(
             axis[0], glm::dot(axis[0], (center + axis[0] * halfWidth.x)));
@@ -350,37 +339,13 @@ std::vector<Plane> OBB::GetPlanes() {
     return result;
 }
 
+// Projection of the center plus or minus projected half extents
 Interval OBB::GetInterval(Vec3 axisPar) {
-    Vec3 vertex[8];
-
-    vertex[0] = center + axis[0] * halfWidth[0]
-        + axis[1] * halfWidth[1] + axis[2] * halfWidth[2];
-    vertex[1] = center - axis[0] * halfWidth[0]
-        + axis[1] * halfWidth[1] + axis[2] * halfWidth[2];
-    vertex[2] = center + axis[0] * halfWidth[0]
-        - axis[1] * halfWidth[1] + axis[2] * halfWidth[2];
-    vertex[3] = center + axis[0] * halfWidth[0]
-        + axis[1] * halfWidth[1] - axis[2] * halfWidth[2];
-    vertex[4] = center - axis[0] * halfWidth[0]
-        - axis[1] * halfWidth[1] - axis[2] * halfWidth[2];
-    vertex[5] = center + axis[0] * halfWidth[0]
-        - axis[1] * halfWidth[1] - axis[2] * halfWidth[2];
-    vertex[6] = center - axis[0] * halfWidth[0]
-        + axis[1] * halfWidth[1] - axis[2] * halfWidth[2];
-    vertex[7] = center - axis[0] * halfWidth[0]
-        - axis[1] * halfWidth[1] + axis[2] * halfWidth[2];
-
-    Interval result;
-    result.min = result.max = glm::dot(axisPar, vertex[0]);
-    for (int i = 1; i < 8; i++) {
-        float projection = glm::dot(axisPar, vertex[i]);
-        result.min = (projection < result.min) ?
-            projection : result.min;
-        result.max = (projection > result.max) ?
-            projection : result.max;
-    }
-
-    return result;
+    float projection = glm::dot(axisPar, center);
+    float radius = 0.f;
+    for (int i = 0; i < 3; i++)
+        radius += std::abs(glm::dot(axisPar, axis[i])) * halfWidth[i];
+    return Interval{projection - radius, projection + radius};
 }
 
 Vec3 OBB::ClosestPoint(Vec3 point) {
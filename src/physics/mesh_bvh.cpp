@@ -0,0 +1,184 @@
+#include "mesh_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include "mesh.hpp"
+
+namespace {
+
+const AABB EMPTY_BOUNDS = {
+    Vec3(std::numeric_limits<float>::max()),
+    Vec3(-std::numeric_limits<float>::max()),
+};
+
+void Grow(AABB *box, const AABB &other) {
+    box->min = glm::min(box->min, other.min);
+    box->max = glm::max(box->max, other.max);
+}
+
+void Grow(AABB *box, Vec3 point) {
+    box->min = glm::min(box->min, point);
+    box->max = glm::max(box->max, point);
+}
+
+struct Builder {
+    std::vector<AABB> bounds;
+    std::vector<Vec3> centroids;
+    std::vector<int> *triangles;
+    std::vector<MeshBVH::Node> *nodes;
+
+    // Returns index of the node for triangles [begin, end)
+    int Build(int begin, int end, int depth);
+    // Partitions triangles by the cheapest bin boundary, returns end of the
+    // left half or -1 if bins do not split them. Sets `*cost` in units of
+    // one triangle test, traversal step costs one as well
+    int SplitSAH(int begin, int end, int axis, const AABB &box, const AABB &centroidBox, float *cost);
+};
+
+int Builder::Build(int begin, int end, int depth) {
+    int index = static_cast<int>(nodes->size());
+    nodes->push_back(MeshBVH::Node{EMPTY_BOUNDS, begin, end - begin});
+
+    AABB box = EMPTY_BOUNDS, centroidBox = EMPTY_BOUNDS;
+    for (int i = begin; i < end; i++) {
+        Grow(&box, bounds[(*triangles)[i]]);
+        Grow(&centroidBox, centroids[(*triangles)[i]]);
+    }
+    (*nodes)[index].bounds = box;
+
+    Vec3 extent = centroidBox.max - centroidBox.min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    // Triangles with the same centroid can not be told apart, they stay in one leaf
+    if (end - begin == 1 || extent[axis] <= 0.f)
+        return index;
+
+    int middle = -1;
+    float cost = 0.f;
+    bool small = end - begin <= BVH_MAX_LEAF_TRIANGLES;
+    if (depth < BVH_SAH_DEPTH) {
+        // Small leaves are kept unless splitting them is cheaper than testing every triangle
+        middle = SplitSAH(begin, end, axis, box, centroidBox, &cost);
+        if (small && (middle == -1 || cost >= end - begin))
+            return index;
+    } else if (small) {
+        return index;
+    }
+    if (middle == -1) {
+        middle = (begin + end) / 2;
+        std::nth_element(triangles->begin() + begin, triangles->begin() + middle,
+            triangles->begin() + end, [&](int a, int b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+    }
+
+    Build(begin, middle, depth + 1);
+    int right = Build(middle, end, depth + 1);
+    (*nodes)[index].offset = right;
+    (*nodes)[index].count = 0;
+    return index;
+}
+
+int Builder::SplitSAH(int begin, int end, int axis, const AABB &box, const AABB &centroidBox,
+        float *cost) {
+    struct Bin {
+        AABB bounds = EMPTY_BOUNDS;
+        int count = 0;
+    };
+    Bin bins[BVH_BIN_COUNT];
+    float origin = centroidBox.min[axis];
+    float scale = BVH_BIN_COUNT / (centroidBox.max[axis] - origin);
+    if (!std::isfinite(scale))
+        return -1;
+    auto binOf = [&](int triangle) {
+        int bin = static_cast<int>((centroids[triangle][axis] - origin) * scale);
+        return std::min(bin, BVH_BIN_COUNT - 1);
+    };
+    for (int i = begin; i < end; i++) {
+        Bin &bin = bins[binOf((*triangles)[i])];
+        Grow(&bin.bounds, bounds[(*triangles)[i]]);
+        bin.count++;
+    }
+
+    // rightCost[i] is the cost of bins (i, BVH_BIN_COUNT)
+    float rightCost[BVH_BIN_COUNT];
+    AABB accumulated = EMPTY_BOUNDS;
+    int count = 0;
+    for (int i = BVH_BIN_COUNT - 1; i > 0; i--) {
+        Grow(&accumulated, bins[i].bounds);
+        count += bins[i].count;
+        rightCost[i - 1] = count > 0 ? MeshBVH::Area(accumulated) * count : 0.f;
+    }
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestSplit = -1;
+    accumulated = EMPTY_BOUNDS;
+    count = 0;
+    float area = MeshBVH::Area(box);
+    for (int i = 0; i < BVH_BIN_COUNT - 1; i++) {
+        Grow(&accumulated, bins[i].bounds);
+        count += bins[i].count;
+        if (count == 0 || count == end - begin)
+            continue;
+        float cost = 1.f + (MeshBVH::Area(accumulated) * count + rightCost[i]) / area;
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSplit = i;
+        }
+    }
+    if (bestSplit == -1)
+        return -1;
+    *cost = bestCost;
+
+    auto middle = std::partition(triangles->begin() + begin, triangles->begin() + end,
+        [&](int triangle) { return binOf(triangle) <= bestSplit; });
+    return static_cast<int>(middle - triangles->begin());
+}
+
+}  // namespace
+
+void MeshBVH::Build(const Vertex *points, const unsigned int *indices, int indexCount) {
+    Clear();
+    int count = indexCount / 3;
+    if (count == 0)
+        return;
+
+    Builder builder;
+    builder.bounds.resize(count);
+    builder.centroids.resize(count);
+    for (int i = 0; i < count; i++) {
+        AABB box = EMPTY_BOUNDS;
+        for (int j = 0; j < 3; j++)
+            Grow(&box, points[indices[3 * i + j]].Position);
+        builder.bounds[i] = box;
+        builder.centroids[i] = (box.min + box.max) * 0.5f;
+    }
+    m_Triangles.resize(count);
+    std::iota(m_Triangles.begin(), m_Triangles.end(), 0);
+    m_Nodes.reserve(2 * count - 1);
+    builder.triangles = &m_Triangles;
+    builder.nodes = &m_Nodes;
+    builder.Build(0, count, 0);
+}
+
+void MeshBVH::Clear() {
+    m_Nodes.clear();
+    m_Triangles.clear();
+}
+
+bool MeshBVH::IsEmpty() const {
+    return m_Nodes.empty();
+}
+
+const AABB &MeshBVH::GetBounds() const {
+    return m_Nodes[0].bounds;
+}
+
+int MeshBVH::GetNodeCount() const {
+    return static_cast<int>(m_Nodes.size());
+}
+
+float MeshBVH::Area(const AABB &box) {
+    Vec3 size = box.max - box.min;
+    return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
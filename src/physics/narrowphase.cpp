@@ -0,0 +1,287 @@
+#include "narrowphase.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <variant>
+
+void SphereArray::Resize(int size) {
+    centerX.resize(size);
+    centerY.resize(size);
+    centerZ.resize(size);
+    radius.resize(size);
+}
+
+void SphereArray::Set(int index, const Sphere &sphere) {
+    centerX[index] = sphere.center.x;
+    centerY[index] = sphere.center.y;
+    centerZ[index] = sphere.center.z;
+    radius[index] = sphere.radius;
+}
+
+void AABBArray::Resize(int size) {
+    minX.resize(size);
+    minY.resize(size);
+    minZ.resize(size);
+    maxX.resize(size);
+    maxY.resize(size);
+    maxZ.resize(size);
+}
+
+void AABBArray::Set(int index, const AABB &box) {
+    minX[index] = box.min.x;
+    minY[index] = box.min.y;
+    minZ[index] = box.min.z;
+    maxX[index] = box.max.x;
+    maxY[index] = box.max.y;
+    maxZ[index] = box.max.z;
+}
+
+void ManifoldArray::Resize(int size) {
+    collide.resize(size);
+    normalX.resize(size);
+    normalY.resize(size);
+    normalZ.resize(size);
+    pointX.resize(size);
+    pointY.resize(size);
+    pointZ.resize(size);
+    depth.resize(size);
+}
+
+CollisionManifold ManifoldArray::Get(int index) const {
+    CollisionManifold res;
+    if (!collide[index])
+        return res;
+    res.collide = true;
+    res.collisionNormal = Vec3(normalX[index], normalY[index], normalZ[index]);
+    res.collisionPoint = Vec3(pointX[index], pointY[index], pointZ[index]);
+    res.penetrationDistance = depth[index];
+    return res;
+}
+
+// Same as CollidePrimitive(Sphere, Sphere)
+void CollideBatch(const SphereArray &a, const SphereArray &b, int begin, int end, ManifoldArray *out) {
+    const float *ax = a.centerX.data(), *ay = a.centerY.data(), *az = a.centerZ.data();
+    const float *ar = a.radius.data();
+    const float *bx = b.centerX.data(), *by = b.centerY.data(), *bz = b.centerZ.data();
+    const float *br = b.radius.data();
+    uint8_t *collide = out->collide.data();
+    float *nx = out->normalX.data(), *ny = out->normalY.data(), *nz = out->normalZ.data();
+    float *px = out->pointX.data(), *py = out->pointY.data(), *pz = out->pointZ.data();
+    float *depth = out->depth.data();
+    // Arrays of a batch never overlap. Without this the compiler needs more
+    // run-time overlap checks than it is willing to emit and keeps the loop scalar
+#pragma GCC ivdep
+    for (int i = begin; i < end; i++) {
+        float dx = ax[i] - bx[i], dy = ay[i] - by[i], dz = az[i] - bz[i];
+        float r = ar[i] + br[i];
+        float length2 = dx * dx + dy * dy + dz * dz;
+        float length = std::sqrt(length2);
+        // Coinciding centers give zero normal, as Norm does, since the difference
+        // is zero. Square root of a float is never below FLT_MIN unless it is zero
+        float safeLength = glm::max(length, FLT_MIN);
+        float penetration = std::abs(length - r) * 0.5f;
+        float toContact = ar[i] - penetration;
+        collide[i] = length2 <= r * r;
+        nx[i] = dx / safeLength;
+        ny[i] = dy / safeLength;
+        nz[i] = dz / safeLength;
+        px[i] = ax[i] + dx * toContact;
+        py[i] = ay[i] + dy * toContact;
+        pz[i] = az[i] + dz * toContact;
+        depth[i] = penetration;
+    }
+}
+
+// Same as CollidePrimitive(Sphere, AABB)
+void CollideBatch(const SphereArray &a, const AABBArray &b, int begin, int end, ManifoldArray *out) {
+    const float *cx = a.centerX.data(), *cy = a.centerY.data(), *cz = a.centerZ.data();
+    const float *radius = a.radius.data();
+    const float *minX = b.minX.data(), *minY = b.minY.data(), *minZ = b.minZ.data();
+    const float *maxX = b.maxX.data(), *maxY = b.maxY.data(), *maxZ = b.maxZ.data();
+    uint8_t *collide = out->collide.data();
+    float *nx = out->normalX.data(), *ny = out->normalY.data(), *nz = out->normalZ.data();
+    float *px = out->pointX.data(), *py = out->pointY.data(), *pz = out->pointZ.data();
+    float *depth = out->depth.data();
+#pragma GCC ivdep
+    for (int i = begin; i < end; i++) {
+        // Closest point of the box
+        float qx = glm::min(glm::max(cx[i], minX[i]), maxX[i]);
+        float qy = glm::min(glm::max(cy[i], minY[i]), maxY[i]);
+        float qz = glm::min(glm::max(cz[i], minZ[i]), maxZ[i]);
+        float ex = cx[i] - qx, ey = cy[i] - qy, ez = cz[i] - qz;
+        float distance2 = ex * ex + ey * ey + ez * ez;
+
+        // Center inside of the box pushes out from the center of the box
+        bool inside = distance2 <= FLT_EPSILON;
+        float mx = qx - (minX[i] + maxX[i]) * 0.5f;
+        float my = qy - (minY[i] + maxY[i]) * 0.5f;
+        float mz = qz - (minZ[i] + maxZ[i]) * 0.5f;
+        float vx = inside ? mx : ex, vy = inside ? my : ey, vz = inside ? mz : ez;
+        float length = std::sqrt(vx * vx + vy * vy + vz * vz);
+        // Center of the sphere at the center of the box has no normal
+        bool degenerate = inside & (length <= FLT_EPSILON);
+        float inverse = (degenerate ? 0.f : 1.f) / glm::max(length, FLT_MIN);
+        vx *= inverse, vy *= inverse, vz *= inverse;
+
+        float ox = cx[i] - vx * radius[i], oy = cy[i] - vy * radius[i], oz = cz[i] - vz * radius[i];
+        float wx = ox - qx, wy = oy - qy, wz = oz - qz;
+        float distance = std::sqrt(wx * wx + wy * wy + wz * wz);
+        collide[i] = distance2 <= radius[i] * radius[i];
+        nx[i] = vx;
+        ny[i] = vy;
+        nz[i] = vz;
+        px[i] = qx + wx * 0.5f;
+        py[i] = qy + wy * 0.5f;
+        pz[i] = qz + wz * 0.5f;
+        depth[i] = degenerate ? std::numeric_limits<float>::max() : distance * 0.5f;
+    }
+}
+
+// Same as CollidePrimitive(AABB, AABB)
+void CollideBatch(const AABBArray &a, const AABBArray &b, int begin, int end, ManifoldArray *out) {
+    const float *aMinX = a.minX.data(), *aMinY = a.minY.data(), *aMinZ = a.minZ.data();
+    const float *aMaxX = a.maxX.data(), *aMaxY = a.maxY.data(), *aMaxZ = a.maxZ.data();
+    const float *bMinX = b.minX.data(), *bMinY = b.minY.data(), *bMinZ = b.minZ.data();
+    const float *bMaxX = b.maxX.data(), *bMaxY = b.maxY.data(), *bMaxZ = b.maxZ.data();
+    uint8_t *collide = out->collide.data();
+    float *nx = out->normalX.data(), *ny = out->normalY.data(), *nz = out->normalZ.data();
+    float *px = out->pointX.data(), *py = out->pointY.data(), *pz = out->pointZ.data();
+    float *depth = out->depth.data();
+#pragma GCC ivdep
+    for (int i = begin; i < end; i++) {
+        // Sum of lengths minus length of the union, rounded as PenetrationDepth does
+        float overlapX = (aMaxX[i] - aMinX[i]) + (bMaxX[i] - bMinX[i])
+            - (glm::max(aMaxX[i], bMaxX[i]) - glm::min(aMinX[i], bMinX[i]));
+        float overlapY = (aMaxY[i] - aMinY[i]) + (bMaxY[i] - bMinY[i])
+            - (glm::max(aMaxY[i], bMaxY[i]) - glm::min(aMinY[i], bMinY[i]));
+        float overlapZ = (aMaxZ[i] - aMinZ[i]) + (bMaxZ[i] - bMinZ[i])
+            - (glm::max(aMaxZ[i], bMaxZ[i]) - glm::min(aMinZ[i], bMinZ[i]));
+        // Normal points from `b` to `a` along the axis of the smallest overlap
+        float signX = bMinX[i] < aMinX[i] ? 1.f : -1.f;
+        float signY = bMinY[i] < aMinY[i] ? 1.f : -1.f;
+        float signZ = bMinZ[i] < aMinZ[i] ? 1.f : -1.f;
+        // Axes are taken in order x, y, z and replace the previous one only when
+        // overlap is strictly smaller. Every step is a select, so there is no branch
+        float normalX = signX, normalY = 0.f, normalZ = 0.f, smallest = overlapX;
+        normalX = overlapY < smallest ? 0.f : normalX;
+        normalY = overlapY < smallest ? signY : normalY;
+        smallest = overlapY < smallest ? overlapY : smallest;
+        normalX = overlapZ < smallest ? 0.f : normalX;
+        normalY = overlapZ < smallest ? 0.f : normalY;
+        normalZ = overlapZ < smallest ? signZ : normalZ;
+        smallest = overlapZ < smallest ? overlapZ : smallest;
+        collide[i] = (overlapX > 0.f) & (overlapY > 0.f) & (overlapZ > 0.f);
+        nx[i] = normalX;
+        ny[i] = normalY;
+        nz[i] = normalZ;
+        px[i] = 0.f;
+        py[i] = 0.f;
+        pz[i] = 0.f;
+        depth[i] = smallest;
+    }
+}
+
+template<typename First, typename Second>
+void Narrowphase::Batch<First, Second>::Clear() {
+    pairs.clear();
+    swapped.clear();
+}
+
+template<typename First, typename Second>
+void Narrowphase::Batch<First, Second>::Add(int pair, bool swap) {
+    pairs.push_back(pair);
+    swapped.push_back(swap);
+}
+
+const Sphere &Narrowphase::GetShape(ObjectHandle handle, const SphereArray *) const {
+    return m_Spheres[GetHandleIndex(handle)];
+}
+
+const AABB &Narrowphase::GetShape(ObjectHandle handle, const AABBArray *) const {
+    return m_AABBs[GetHandleIndex(handle)];
+}
+
+template<typename First, typename Second>
+void Narrowphase::Run(Batch<First, Second> *batch, const std::vector<BroadphasePair> &pairs,
+        JobSystem *jobs, std::vector<CollisionManifold> *out) {
+    const int count = static_cast<int>(batch->pairs.size());
+    batch->first.Resize(count);
+    batch->second.Resize(count);
+    batch->manifolds.Resize(count);
+    jobs->ParallelFor(count, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const BroadphasePair &pair = pairs[batch->pairs[i]];
+            ObjectHandle first = batch->swapped[i] ? pair.b : pair.a;
+            ObjectHandle second = batch->swapped[i] ? pair.a : pair.b;
+            batch->first.Set(i, GetShape(first, &batch->first));
+            batch->second.Set(i, GetShape(second, &batch->second));
+        }
+
+        CollideBatch(batch->first, batch->second, begin, end, &batch->manifolds);
+
+        for (int i = begin; i < end; i++) {
+            CollisionManifold manifold = batch->manifolds.Get(i);
+            if (batch->swapped[i])
+                manifold.collisionNormal *= -1;
+            (*out)[batch->pairs[i]] = manifold;
+        }
+    });
+}
+
+void Narrowphase::Collide(const std::vector<BroadphasePair> &pairs, PackedArray<Collider> *colliders,
+        const std::vector<Transform> &transforms, JobSystem *jobs,
+        std::vector<CollisionManifold> *out) {
+    // Colliders are read in storage order, so pairs below only look up small arrays
+    m_Kinds.resize(transforms.size());
+    m_Spheres.resize(transforms.size());
+    m_AABBs.resize(transforms.size());
+    jobs->ParallelFor(colliders->GetSize(), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int slot = GetHandleIndex(colliders->GetFromInternal(i));
+            const auto &shape = colliders->entries[i].shape;
+            if (auto sphere = std::get_if<Sphere>(&shape)) {
+                m_Kinds[slot] = SPHERE;
+                m_Spheres[slot] = sphere->Transformed(transforms[slot]);
+            } else if (auto box = std::get_if<AABB>(&shape)) {
+                m_Kinds[slot] = BOX;
+                m_AABBs[slot] = box->Transformed(transforms[slot]);
+            } else {
+                m_Kinds[slot] = OTHER;
+            }
+        }
+    });
+
+    m_SphereSphere.Clear();
+    m_SphereAABB.Clear();
+    m_AABBAABB.Clear();
+    m_Other.clear();
+    for (int i = 0; i < pairs.size(); i++) {
+        Kind a = static_cast<Kind>(m_Kinds[GetHandleIndex(pairs[i].a)]);
+        Kind b = static_cast<Kind>(m_Kinds[GetHandleIndex(pairs[i].b)]);
+        if (a == SPHERE && b == SPHERE)
+            m_SphereSphere.Add(i, false);
+        else if (a == SPHERE && b == BOX)
+            m_SphereAABB.Add(i, false);
+        else if (a == BOX && b == SPHERE)
+            m_SphereAABB.Add(i, true);
+        else if (a == BOX && b == BOX)
+            m_AABBAABB.Add(i, false);
+        else
+            m_Other.push_back(i);
+    }
+
+    out->resize(pairs.size());
+    Run(&m_SphereSphere, pairs, jobs, out);
+    Run(&m_SphereAABB, pairs, jobs, out);
+    Run(&m_AABBAABB, pairs, jobs, out);
+
+    jobs->ParallelFor(static_cast<int>(m_Other.size()), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const BroadphasePair &pair = pairs[m_Other[i]];
+            (*out)[m_Other[i]] = colliders->GetData(pair.a).Collide(
+                    transforms[GetHandleIndex(pair.a)], &colliders->GetData(pair.b),
+                    transforms[GetHandleIndex(pair.b)]);
+        }
+    });
+}
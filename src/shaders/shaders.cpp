@@ -10,6 +10,7 @@
 #include "path_resolver.hpp"
 #include "glm/ext.hpp"
 #include "engine_config.hpp"
+#include "backend.hpp"
 
 int Shader::CheckSuccess() {
     int success;
@@ -35,6 +36,8 @@ void Shader::LoadSourceFromFile(std::string path) {
 }
 
 int Shader::Compile() {
+    if (!Backend::HasGraphics())
+        return 0;
     if (m_Shader == 0)
         m_Shader = glCreateShader(m_Type);
     const char* source = m_Source.c_str();
@@ -48,6 +51,8 @@ int Shader::Compile() {
 Shader::Shader(ShaderType shaderType, std::string path) {
     m_Type = shaderType;
     m_Shader = 0;
+    if (!Backend::HasGraphics())
+        return;
     if (shaderType == VertexShader) {
         path = GetResourcePath(Resource::VSHADER, path);
     } else {
@@ -76,6 +81,11 @@ int ShaderProgram::Link() {
         m_Program = 0;
         return 1;
     }
+    m_Locations.clear();
+    unsigned int lightsBlock = glGetUniformBlockIndex(m_Program, LIGHTS_UNIFORM_BLOCK);
+    if (lightsBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_Program, lightsBlock, LIGHTS_UNIFORM_BINDING);
+    m_Instanced = glGetAttribLocation(m_Program, INSTANCE_MATRIX_ATTRIBUTE) != -1;
     return 0;
 }
 
@@ -84,6 +94,10 @@ ShaderProgram::ShaderProgram() {
 }
 
 ShaderProgram::ShaderProgram(Shader vShader, Shader fShader) {
+    if (!Backend::HasGraphics()) {
+        m_Program = 0;
+        return;
+    }
     m_Program = glCreateProgram();
     AttachShader(vShader);
     AttachShader(fShader);
@@ -95,12 +109,23 @@ int ShaderProgram::Use() {
     return 0;
 }
 
+unsigned int ShaderProgram::GetId() const {
+    return m_Program;
+}
+
+bool ShaderProgram::IsInstanced() const {
+    return m_Instanced;
+}
+
 int ShaderProgram::UniformLocation(const char* mode) {
     return glGetUniformLocation(m_Program, mode);
 }
 
-unsigned int ShaderProgram::GetLoc(const char* name) {
-    return UniformLocation(name);
+int ShaderProgram::GetLoc(const char* name) {
+    auto it = m_Locations.find(name);
+    if (it == m_Locations.end())
+        it = m_Locations.emplace(name, UniformLocation(name)).first;
+    return it->second;
 }
 
 void ShaderProgram::SetFloat(const char* name, const float value) { glUniform1f(GetLoc(name), value); }
@@ -138,3 +163,7 @@ void ShaderProgram::SetMat3(const char* name, Mat3 mat) {
 void ShaderProgram::SetMat4(const char* name, Mat4 mat) {
     glUniformMatrix4fv(GetLoc(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
+
+void ShaderProgram::SetMat4Array(const char* name, const Mat4* mats, int count) {
+    glUniformMatrix4fv(GetLoc(name), count, GL_FALSE, glm::value_ptr(mats[0]));
+}
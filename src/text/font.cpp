@@ -11,17 +11,19 @@
 #include "user_config.hpp"
 #include "engine_config.hpp"
 #include "path_resolver.hpp"
+#include "backend.hpp"
+#include "asset_manager.hpp"
 
 void Font::RenderText(std::string text, float relX, float relY, float scale, glm::vec3 color) {
     glDisable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    m_ShaderProgram.Use();
+    m_ShaderProgram->Use();
     glm::mat4 projection =
         glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
-    m_ShaderProgram.SetMat4("projection", projection);
-    m_ShaderProgram.SetVec3("textColor", color);
+    m_ShaderProgram->SetMat4("projection", projection);
+    m_ShaderProgram->SetVec3("textColor", color);
 
     glActiveTexture(GL_TEXTURE0);
     glBindVertexArray(m_VAO);
@@ -68,6 +70,8 @@ void Font::RenderText(std::string text, float relX, float relY, float scale, glm
 }
 
 Font::Font(std::string path, unsigned int fontSize) {
+    if (!Backend::HasGraphics())
+        return;
     path = GetResourcePath(Resource::FONT, path);
 
     FT_Library ft;
@@ -133,7 +137,5 @@ Font::Font(std::string path, unsigned int fontSize) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    Shader vShader = Shader(VertexShader, "text.vshader");
-    Shader fShader = Shader(FragmentShader, "text.fshader");
-    m_ShaderProgram = ShaderProgram(vShader, fShader);
+    m_ShaderProgram = AssetManager::LoadShaderProgram("text.vshader", "text.fshader");
 }
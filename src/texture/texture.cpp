@@ -5,6 +5,8 @@
 #include "engine_config.hpp"
 #include "logger.hpp"
 #include "path_resolver.hpp"
+#include "backend.hpp"
+#include "asset_manager.hpp"
 
 Texture::Texture() {}
 
@@ -25,60 +27,113 @@ void Texture::loadImages(std::vector<std::string> paths) {
 }
 
 void Texture::loadImage(std::string path) {
-    path = GetResourcePath(Resource::TEXTURE, path);
-
+    if (!Backend::HasGraphics())
+        return;
     if (m_Count >= MAX_COUNT_TEXTURE) {
         Logger::Error(
             "TEXTURE::PROGRAM::LOADER::FAILED_TO_LOAD_TEXTURE_AT_PATH_%s_BECAUSE_OVERFLOW", path.c_str());
         return;
     }
 
-    int width, height, nrComponents;
+    auto texture = AssetManager::LoadTexture(path);
+    if (!texture)
+        return;
+    m_Textures[m_Count] = std::move(texture);
+    m_Count++;
+}
+
+int Texture::countComponents() const {
+    return m_Count;
+}
+
+unsigned int Texture::textureId(int idx) const {
+    if (idx < 0 || idx >= m_Count) {
+        Logger::Error("TEXTURE::PROGRAM:INDEX_OUT_OF_BOUNDS");
+        exit(1);
+    }
+    return m_Textures[idx]->id;
+}
+
+void Texture::bind() {
+    for (int i = 0; i < m_Count; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, m_Textures[i]->id);
+    }
+}
+
+TextureAsset::~TextureAsset() {
+    if (id != 0)
+        glDeleteTextures(1, &id);
+}
+
+DecodedImage DecodedImage::Decode(const std::string &path) {
+    DecodedImage image;
     unsigned char *data = reinterpret_cast<unsigned char*>(
-        stbi_load(path.c_str(), &width, &height, &nrComponents, 0));
+        stbi_load(path.c_str(), &image.width, &image.height, &image.components, 0));
+    if (data)
+        image.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+    return image;
+}
 
-    if (!data) {
-        stbi_image_free(data);
+std::shared_ptr<const TextureAsset> TextureAsset::FromFile(const std::string &path) {
+    DecodedImage image = DecodedImage::Decode(path);
+    if (!image.pixels) {
         Logger::Error("TEXTURE::LOADER::PROGRAM::FILE_NOT_FOUND_FAILED: %s", path.c_str());
-        return;
+        return nullptr;
     }
-    GLenum format = nrComponents == 4 ? GL_RGBA : GL_RGB;
+    return FromDecoded(image);
+}
 
-    glGenTextures(1, &m_TextureId[m_Count]);
+std::shared_ptr<const TextureAsset> TextureAsset::FromDecoded(const DecodedImage &image) {
+    if (!image.pixels)
+        return nullptr;
+    GLenum format = image.components == 4 ? GL_RGBA : GL_RGB;
 
-    glBindTexture(GL_TEXTURE_2D, m_TextureId[m_Count]);
+    auto texture = std::make_shared<TextureAsset>();
+    texture->width = image.width;
+    texture->height = image.height;
+    glGenTextures(1, &texture->id);
+
+    glBindTexture(GL_TEXTURE_2D, texture->id);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
     glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE,
+                 image.pixels.get());
     glGenerateMipmap(GL_TEXTURE_2D);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-    m_Count++;
+    return texture;
 }
 
-int Texture::countComponents() {
-    return m_Count;
-}
+std::shared_ptr<const TextureAsset> TextureAsset::FromImageFile(const std::string &path) {
+    int width, height, nrComponents;
+    unsigned char *data = reinterpret_cast<unsigned char*>(
+        stbi_load(path.c_str(), &width, &height, &nrComponents, 0));
 
-unsigned int Texture::textureId(int idx) {
-    if (idx < 0 || idx > m_Count) {
-        Logger::Error("TEXTURE::PROGRAM:INDEX_OUT_OF_BOUNDS");
-        exit(1);
+    if (!data) {
+        stbi_image_free(data);
+        Logger::Error("IMAGE::LOADER::FILE_NOT_FOUND_FAILED: %s", path.c_str());
+        return nullptr;
     }
-    return m_TextureId[idx];
-}
 
-void Texture::bind() {
-    for (int i = 0; i < m_Count; i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, m_TextureId[i]);
-    }
+    auto texture = std::make_shared<TextureAsset>();
+    texture->width = width;
+    texture->height = height;
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    stbi_image_free(data);
+    return texture;
 }
 